@@ -0,0 +1,473 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include <QtTest>
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <QtLibArchive/Reader.h>
+#include <QtLibArchive/Writer.h>
+
+#include <atomic>
+#include <functional>
+#include <iterator>
+
+// Counts heap allocations, including those made by Qt and libarchive, by interposing malloc.
+// Frees are not tracked, the benchmarks only report what was allocated.
+#if defined(__GLIBC__)
+#define QTLIBARCHIVE_COUNT_ALLOCATIONS
+
+namespace {
+std::atomic<bool> countAllocations{false};
+std::atomic<qint64> allocationCount{0};
+std::atomic<qint64> allocatedBytes{0};
+
+void recordAllocation(size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(static_cast<qint64>(size), std::memory_order_relaxed);
+    }
+}
+} // namespace
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+void* malloc(size_t size) noexcept
+{
+    recordAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    recordAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept
+{
+    recordAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+namespace {
+enum class Metric {
+    /*! Time per run, measured by QBENCHMARK and thus any backend selected on the command line. */
+    Time,
+    /*! Uncompressed bytes processed per second. */
+    Throughput,
+    /*! Number of heap allocations in one run. */
+    Allocations,
+    /*! Bytes allocated on the heap in one run. */
+    AllocatedBytes,
+};
+
+struct ArchiveType
+{
+    const char* name;
+    QtLibArchive::SupportedFormat format;
+    QtLibArchive::SupportedFilter filter;
+};
+
+// 7z and zip compress the entries themselves and are not combined with filters.
+using QtLibArchive::SupportedFilter;
+using QtLibArchive::SupportedFormat;
+
+const ArchiveType ArchiveTypes[] = {
+    {"tar", SupportedFormat::TarPaxRestricted, SupportedFilter::None},
+    {"tar-gzip", SupportedFormat::TarPaxRestricted, SupportedFilter::Gzip},
+    {"tar-zstd", SupportedFormat::TarPaxRestricted, SupportedFilter::Zstd},
+    {"tar-xz", SupportedFormat::TarPaxRestricted, SupportedFilter::Xz},
+    {"zip", SupportedFormat::Zip, SupportedFilter::None},
+    {"7z", SupportedFormat::SevenZip, SupportedFilter::None},
+};
+
+struct CorpusFile
+{
+    QString path;
+    QByteArray data;
+};
+
+struct Corpus
+{
+    QString name;
+    QList<CorpusFile> files;
+    qint64 bytes{0};
+};
+
+/*!
+ * Generates log-like text interspersed with random bytes, which compresses to roughly a third
+ * of its size, so that the codecs neither idle nor dominate.
+ */
+QByteArray generateContent(QRandomGenerator& random, qint64 size)
+{
+    static const QByteArrayList Words{
+        "INFO", "DEBUG", "WARNING", "request", "response", "connection", "timeout", "archive"};
+
+    QByteArray data;
+    data.reserve(static_cast<int>(size));
+
+    while (data.size() < size) {
+        if (random.bounded(10) == 0) {
+            for (int i = 0; i < 64; ++i) {
+                data.append(static_cast<char>(random.bounded(256)));
+            }
+        } else {
+            data.append(Words.at(random.bounded(Words.size())));
+            data.append(' ');
+            data.append(QByteArray::number(random.bounded(100000)));
+            data.append('\n');
+        }
+    }
+
+    data.truncate(static_cast<int>(size));
+    return data;
+}
+
+Corpus generateCorpus(
+    const QString& name, int fileCount, const std::function<qint64(QRandomGenerator&)>& fileSize)
+{
+    // A fixed seed keeps the corpora identical across runs and releases.
+    QRandomGenerator random{42};
+    Corpus corpus{name, {}, 0};
+
+    for (int i = 0; i < fileCount; ++i) {
+        CorpusFile file;
+        file.path = QStringLiteral("dir%1/file%2.txt").arg(i / 100).arg(i);
+        file.data = generateContent(random, fileSize(random));
+
+        corpus.bytes += file.data.size();
+        corpus.files.push_back(std::move(file));
+    }
+
+    return corpus;
+}
+} // namespace
+
+Q_DECLARE_METATYPE(Metric)
+
+/*!
+ * Benchmarks the read and write paths on generated corpora. The corpora are scaled by the
+ * environment variable QTLIBARCHIVE_BENCHMARK_SCALE, which defaults to 1.
+ *
+ * Every benchmark is run per archive type, corpus and metric. Pass e.g. "-o results.xml,xml" to
+ * get machine-readable results, the qtlibarchive_run_benchmarks target does so.
+ */
+class ArchiveBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void writerAddFile_data();
+    void writerAddFile();
+    void iteratorNext_data();
+    void iteratorNext();
+    void iteratorReadData_data();
+    void iteratorReadData();
+    void readerFileData_data();
+    void readerFileData();
+    void readerFileCount_data();
+    void readerFileCount();
+
+private:
+    void benchmarkData();
+    bool measure(Metric metric, qint64 bytes, const std::function<bool()>& operation);
+    QString archivePath(int archive, int corpus);
+
+    QTemporaryDir _dir;
+    QList<Corpus> _corpora;
+};
+
+void ArchiveBenchmark::initTestCase()
+{
+    QVERIFY(_dir.isValid());
+
+    const qint64 scale = qMax(qEnvironmentVariableIntValue("QTLIBARCHIVE_BENCHMARK_SCALE"), 1);
+
+    _corpora.push_back(generateCorpus("small", static_cast<int>(5000 * scale), [](auto& random) {
+        return random.bounded(256, 4096);
+    }));
+    _corpora.push_back(generateCorpus("huge", 2, [scale](auto&) {
+        return scale * 32 * 1024 * 1024;
+    }));
+    _corpora.push_back(generateCorpus("mixed", static_cast<int>(200 * scale), [](auto& random) {
+        return qint64{1} << random.bounded(8, 21);
+    }));
+}
+
+void ArchiveBenchmark::benchmarkData()
+{
+    QTest::addColumn<int>("archive");
+    QTest::addColumn<int>("corpus");
+    QTest::addColumn<Metric>("metric");
+
+    const std::pair<const char*, Metric> metrics[] = {
+        {"time", Metric::Time},
+        {"throughput", Metric::Throughput},
+#ifdef QTLIBARCHIVE_COUNT_ALLOCATIONS
+        {"allocations", Metric::Allocations},
+        {"allocated-bytes", Metric::AllocatedBytes},
+#endif
+    };
+
+    for (int archive = 0; archive < static_cast<int>(std::size(ArchiveTypes)); ++archive) {
+        for (int corpus = 0; corpus < _corpora.size(); ++corpus) {
+            for (const auto& [metricName, metric] : metrics) {
+                QTest::addRow(
+                    "%s/%s/%s",
+                    ArchiveTypes[archive].name,
+                    qPrintable(_corpora.at(corpus).name),
+                    metricName)
+                    << archive << corpus << metric;
+            }
+        }
+    }
+}
+
+/*!
+ * Runs \a operation according to \a metric and reports the result. \a bytes is the amount of
+ * uncompressed data one run processes. Returns false if any run of \a operation failed.
+ */
+bool ArchiveBenchmark::measure(Metric metric, qint64 bytes, const std::function<bool()>& operation)
+{
+    constexpr qint64 MinThroughputNanoseconds = 500 * 1000 * 1000;
+    bool ok = true;
+
+    switch (metric) {
+    case Metric::Time:
+        QBENCHMARK {
+            ok = operation() && ok;
+        }
+        break;
+
+    case Metric::Throughput: {
+        QElapsedTimer timer;
+        qint64 runs = 0;
+
+        timer.start();
+        do {
+            ok = operation() && ok;
+            runs++;
+        } while (timer.nsecsElapsed() < MinThroughputNanoseconds);
+
+        double seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+        QTest::setBenchmarkResult(
+            static_cast<double>(bytes * runs) / seconds, QTest::BytesPerSecond);
+        break;
+    }
+
+    case Metric::Allocations:
+    case Metric::AllocatedBytes:
+#ifdef QTLIBARCHIVE_COUNT_ALLOCATIONS
+        allocationCount = 0;
+        allocatedBytes = 0;
+
+        countAllocations = true;
+        ok = operation();
+        countAllocations = false;
+
+        if (metric == Metric::Allocations) {
+            QTest::setBenchmarkResult(static_cast<qreal>(allocationCount), QTest::Events);
+        } else {
+            QTest::setBenchmarkResult(static_cast<qreal>(allocatedBytes), QTest::BytesAllocated);
+        }
+#endif
+        break;
+    }
+
+    return ok;
+}
+
+/*!
+ * Returns the path of the archive of \a corpus in the \a archive format, writing it on first
+ * use.
+ */
+QString ArchiveBenchmark::archivePath(int archive, int corpus)
+{
+    const ArchiveType& type = ArchiveTypes[archive];
+    const Corpus& files = _corpora.at(corpus);
+    QString path = _dir.filePath(QStringLiteral("%1-%2.archive").arg(type.name, files.name));
+
+    if (QFileInfo::exists(path)) {
+        return path;
+    }
+
+    QtLibArchive::Writer writer{path, type.format, type.filter};
+    for (const CorpusFile& file : files.files) {
+        writer.addFile(file.path, file.data);
+    }
+    writer.close();
+
+    return writer.error() == QtLibArchive::WriterError::None ? path : QString{};
+}
+
+void ArchiveBenchmark::writerAddFile_data()
+{
+    benchmarkData();
+}
+
+void ArchiveBenchmark::writerAddFile()
+{
+    QFETCH(int, archive);
+    QFETCH(int, corpus);
+    QFETCH(Metric, metric);
+
+    const ArchiveType& type = ArchiveTypes[archive];
+    const Corpus& files = _corpora.at(corpus);
+    const QString path = _dir.filePath("written.archive");
+
+    bool ok = measure(metric, files.bytes, [&]() {
+        QtLibArchive::Writer writer{path, type.format, type.filter};
+
+        for (const CorpusFile& file : files.files) {
+            if (!writer.addFile(file.path, file.data)) {
+                return false;
+            }
+        }
+
+        writer.close();
+        return writer.error() == QtLibArchive::WriterError::None;
+    });
+
+    QVERIFY(ok);
+}
+
+void ArchiveBenchmark::iteratorNext_data()
+{
+    benchmarkData();
+}
+
+void ArchiveBenchmark::iteratorNext()
+{
+    QFETCH(int, archive);
+    QFETCH(int, corpus);
+    QFETCH(Metric, metric);
+
+    const Corpus& files = _corpora.at(corpus);
+    const QString path = archivePath(archive, corpus);
+    QVERIFY(!path.isEmpty());
+
+    bool ok = measure(metric, files.bytes, [&]() {
+        QtLibArchive::Reader reader{path};
+        QtLibArchive::ReaderIterator it = reader.iterator();
+
+        int count = 0;
+        while (it.next()) {
+            count++;
+        }
+
+        return count == files.files.size();
+    });
+
+    QVERIFY(ok);
+}
+
+void ArchiveBenchmark::iteratorReadData_data()
+{
+    benchmarkData();
+}
+
+void ArchiveBenchmark::iteratorReadData()
+{
+    QFETCH(int, archive);
+    QFETCH(int, corpus);
+    QFETCH(Metric, metric);
+
+    const Corpus& files = _corpora.at(corpus);
+    const QString path = archivePath(archive, corpus);
+    QVERIFY(!path.isEmpty());
+
+    bool ok = measure(metric, files.bytes, [&]() {
+        QtLibArchive::Reader reader{path};
+        QtLibArchive::ReaderIterator it = reader.iterator();
+
+        qint64 bytes = 0;
+        while (it.next()) {
+            bytes += it.readData().size();
+        }
+
+        return bytes == files.bytes;
+    });
+
+    QVERIFY(ok);
+}
+
+void ArchiveBenchmark::readerFileData_data()
+{
+    benchmarkData();
+}
+
+void ArchiveBenchmark::readerFileData()
+{
+    // Without an index every lookup scans the archive up to the file.
+    constexpr int Lookups = 10;
+
+    QFETCH(int, archive);
+    QFETCH(int, corpus);
+    QFETCH(Metric, metric);
+
+    const Corpus& files = _corpora.at(corpus);
+    const QString path = archivePath(archive, corpus);
+    QVERIFY(!path.isEmpty());
+
+    QList<const CorpusFile*> lookups;
+    qint64 lookupBytes = 0;
+    for (int i = 0; i < Lookups; ++i) {
+        const CorpusFile& file = files.files.at(i * files.files.size() / Lookups);
+        lookups.push_back(&file);
+        lookupBytes += file.data.size();
+    }
+
+    QtLibArchive::Reader reader{path};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    bool ok = measure(metric, lookupBytes, [&]() {
+        for (const CorpusFile* file : lookups) {
+            std::optional<QByteArray> data = reader.fileData(file->path);
+            if (!data || data->size() != file->data.size()) {
+                return false;
+            }
+        }
+
+        return true;
+    });
+
+    QVERIFY(ok);
+}
+
+void ArchiveBenchmark::readerFileCount_data()
+{
+    benchmarkData();
+}
+
+void ArchiveBenchmark::readerFileCount()
+{
+    QFETCH(int, archive);
+    QFETCH(int, corpus);
+    QFETCH(Metric, metric);
+
+    const Corpus& files = _corpora.at(corpus);
+    const QString path = archivePath(archive, corpus);
+    QVERIFY(!path.isEmpty());
+
+    // The count is cached by the reader, so each run starts with a new one.
+    bool ok = measure(metric, files.bytes, [&]() {
+        QtLibArchive::Reader reader{path};
+        return reader.fileCount() == files.files.size();
+    });
+
+    QVERIFY(ok);
+}
+
+QTEST_APPLESS_MAIN(ArchiveBenchmark)
+
+#include "ArchiveBenchmark.moc"
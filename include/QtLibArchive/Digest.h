@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_DIGEST_H
+#define QTLIBARCHIVE_DIGEST_H
+
+#include <QtLibArchive/QtLibArchive.h>
+
+#include <QByteArray>
+#include <QMap>
+
+namespace QtLibArchive {
+/*!
+ * Digests computed over entry data while it is read or written.
+ *
+ * Crc32 is the checksum used by zip and gzip, stored big-endian in 4 bytes. The others are
+ * computed with QCryptographicHash.
+ */
+enum class DigestAlgorithm {
+    Crc32,
+    Md5,
+    Sha1,
+    Sha256,
+    Sha512,
+};
+
+/*! Digests of a single entry by algorithm. */
+using Digests = QMap<DigestAlgorithm, QByteArray>;
+} // namespace QtLibArchive
+
+#endif
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_EXTRACTOPTIONS_H
+#define QTLIBARCHIVE_EXTRACTOPTIONS_H
+
+#include <QtLibArchive/QtLibArchive.h>
+
+#include <QThread>
+
+namespace QtLibArchive {
+/*!
+ * Options for Reader::extractTo().
+ */
+struct ExtractOptions
+{
+    /*! Number of I/O threads writing files while the archive is decompressed. */
+    int threads{QThread::idealThreadCount()};
+
+    /*!
+     * Files up to this size are decompressed into memory and written by the I/O threads.
+     * Larger and sparse files are streamed to disk in blocks on the decompressing thread.
+     */
+    qint64 smallFileSize{1024 * 1024};
+
+    /*! Upper bound for the decompressed data waiting for the I/O threads. */
+    qint64 maxPendingBytes{64 * 1024 * 1024};
+
+    /*! Reserves the size of each file on disk before writing it, where supported. */
+    bool preallocate{true};
+
+    bool restorePermissions{true};
+    bool restoreMtime{true};
+};
+} // namespace QtLibArchive
+
+#endif
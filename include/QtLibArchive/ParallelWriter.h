@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_PARALLELWRITER_H
+#define QTLIBARCHIVE_PARALLELWRITER_H
+
+#include <QtLibArchive/Writer.h>
+#include <QtLibArchive/WriterEntry.h>
+
+#include <QByteArray>
+#include <QString>
+#include <QThread>
+
+#include <functional>
+#include <memory>
+#include <optional>
+
+namespace QtLibArchive {
+class ParallelWriterPrivate;
+
+/*!
+ * Front-end to Writer that prepares entries on worker threads.
+ *
+ * Payloads are loaded (opened, read and prepared) concurrently on a thread pool, while the
+ * entries are committed to the Writer strictly in the order they were added. Committing
+ * happens on the thread calling addFile(), addEntry() and finish(), so the Writer itself is
+ * only ever used from one thread.
+ *
+ * libarchive compresses members while they are written, so compression happens on the
+ * committing thread. Combine this with WriterOptions::compressionThreads for filters that
+ * compress on several threads.
+ */
+class QTLIBARCHIVE_EXPORT ParallelWriter final
+{
+public:
+    /*!
+     * \param writer The writer to commit entries to. It must outlive the ParallelWriter.
+     * \param threads Number of worker threads loading payloads.
+     * \param maxPendingBytes Budget for the payloads being loaded or waiting to be committed.
+     *        Files added with addFile() reserve their size before they are loaded, and adding
+     *        them blocks until they fit, unless nothing else is pending. Payloads passed to
+     *        addEntry() are only counted once loaded, since their size is not known before,
+     *        so they may exceed the budget while they load.
+     */
+    explicit ParallelWriter(
+        Writer* writer,
+        int threads = QThread::idealThreadCount(),
+        qint64 maxPendingBytes = 64 * 1024 * 1024);
+    ParallelWriter(const ParallelWriter&) = delete;
+    ~ParallelWriter();
+
+    ParallelWriter& operator=(const ParallelWriter&) = delete;
+
+    /*! Queues the file \a sourceFilePath to be added as \a pathInArchive. */
+    bool addFile(
+        const QString& pathInArchive,
+        const QString& sourceFilePath,
+        QFileDevice::Permissions permissions = Writer::defaultRegularFilePermissions());
+
+    /*! Queues the file \a sourceFilePath to be added with the metadata of \a entry. */
+    bool addFile(WriterEntry entry, const QString& sourceFilePath);
+
+    /*!
+     * Queues \a entry. \a loadData is called on a worker thread and returns the data of the
+     * entry, or std::nullopt if it cannot be loaded. Entries without data, e.g. directories,
+     * pass an empty function.
+     */
+    bool addEntry(
+        WriterEntry entry, std::function<std::optional<QByteArray>()> loadData = {});
+
+    /*! Waits for all queued entries and commits them. */
+    bool finish();
+
+    [[nodiscard]] WriterError error() const;
+
+private:
+    Q_DECLARE_PRIVATE(ParallelWriter);
+    std::unique_ptr<ParallelWriterPrivate> d_ptr;
+};
+} // namespace QtLibArchive
+
+#endif
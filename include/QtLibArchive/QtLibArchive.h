@@ -104,7 +104,8 @@ enum class ReaderError {
     FormatNotSupported,
     FilterNotSupported,
     CannotOpenFile,
-    CannotReadData
+    CannotReadData,
+    DeviceInUse
 };
 
 QTLIBARCHIVE_EXPORT QDebug operator<<(QDebug dbg, ReaderError error);
@@ -117,7 +118,9 @@ enum class WriterError {
     CannotAddFilter,
     CannotWriteHeader,
     CannotWriteData,
-    InvalidEntry,    
+    InvalidEntry,
+    CannotSetFilterOption,
+    CannotSetFormatOption,
 };
 
 QTLIBARCHIVE_EXPORT QDebug operator<<(QDebug dbg, WriterError error);
@@ -4,17 +4,43 @@
 #ifndef QTLIBARCHIVE_ARCHIVEREADER_H
 #define QTLIBARCHIVE_ARCHIVEREADER_H
 
+#include <QtLibArchive/ExtractOptions.h>
 #include <QtLibArchive/QtLibArchive.h>
 #include <QtLibArchive/ReaderEntry.h>
+#include <QtLibArchive/ReaderIndex.h>
 #include <QtLibArchive/ReaderIterator.h>
+#include <QtLibArchive/ReaderListing.h>
+#include <QtLibArchive/Statistics.h>
 
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
 #include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+
+#include <atomic>
+#include <functional>
+#include <memory>
 
 namespace QtLibArchive {
 class ReaderIterator;
+class ReaderIteratorPrivate;
+class StatisticsAccumulator;
 
+/*!
+ * Reads archives from a file, memory or a QIODevice.
+ *
+ * const functions may be called on one Reader from several threads at once; each of them
+ * opens its own handle. This does not hold for readers created with fromDevice(), whose handles
+ * all read from the same device. Non-const functions must not run concurrently with any other
+ * call.
+ */
 class QTLIBARCHIVE_EXPORT Reader
 {
+    friend class ReaderIteratorPrivate;
+
 public:
     explicit Reader(
         QString fileName,
@@ -23,27 +49,275 @@ public:
 
     explicit Reader(SupportedFormat supportedFormat, SupportedFilter supportedFilter);
 
+    /*!
+     * Creates a reader for an archive held in memory.
+     *
+     * libarchive reads straight from \a data. The reader keeps a reference to it, so the
+     * buffer is not copied as long as the caller does not modify its own copy.
+     */
+    [[nodiscard]] static Reader fromData(
+        QByteArray data,
+        QList<SupportedFormat> supportedFormats = {SupportedFormat::All},
+        QList<SupportedFilter> supportedFilters = {SupportedFilter::All});
+
+    /*!
+     * Creates a reader for an archive provided by \a device, e.g. a socket or a QBuffer.
+     *
+     * The device is opened for reading if it is not open yet. The archive is expected to start
+     * at position 0 of random-access devices; those can be iterated any number of times.
+     * Sequential devices can only be iterated once: the first iterator continues with the data
+     * read while probing the archive on construction. The caller keeps ownership of \a device
+     * and must keep it alive while the reader is used.
+     *
+     * All iterators of the reader share the device. Each of them seeks back to its own
+     * position before reading a random-access device, so they may be interleaved, but not used
+     * from several threads at once. A sequential device is read by one iterator at a time;
+     * others fail with ReaderError::DeviceInUse while it is open.
+     */
+    [[nodiscard]] static Reader fromDevice(
+        QIODevice* device,
+        QList<SupportedFormat> supportedFormats = {SupportedFormat::All},
+        QList<SupportedFilter> supportedFilters = {SupportedFilter::All});
+
     ~Reader();
 
     [[nodiscard]] QString fileName() const;
     [[nodiscard]] QList<SupportedFormat> supportedFormats() const;
     [[nodiscard]] QList<SupportedFilter> supportedFilters() const;
     [[nodiscard]] ReaderError error() const;
+
+    /*!
+     * Returns the number of entries in the archive.
+     *
+     * The count is taken from the index, which is built on first use by reading only the
+     * headers. Entry data is skipped by seeking wherever the input and compression allow it.
+     */
     [[nodiscard]] qint64 fileCount();
 
+    /*!
+     * Returns false if the scan behind fileCount() stopped at a corrupt or truncated header.
+     * The count is then a lower bound rather than the exact number of entries.
+     */
+    [[nodiscard]] bool isFileCountExact() const;
+
     bool open(const QString& fileName, qint64 blockSize = 10240);
 
+    /*!
+     * Opens a local archive file by mapping it into memory.
+     *
+     * libarchive then reads straight from the mapping instead of issuing a read() call per
+     * block, and the kernel is advised to read ahead sequentially. If the file cannot be
+     * mapped (e.g. because it is a pipe or empty), this falls back to open(). Iterators hold
+     * on to the mapping, so it stays valid when the reader is reopened.
+     */
+    bool openMapped(const QString& fileName);
+
+    /*! Returns true if the archive is read from a memory mapping, see openMapped(). */
+    [[nodiscard]] bool isMapped() const;
+
+    /*!
+     * Reads up to \a blocks blocks of the archive file ahead on a background thread, so disk
+     * I/O overlaps with decompression and with the work done on the entries. 0 disables it.
+     *
+     * Only applies to archives opened with open() or the file name constructor, and to
+     * iterators created after the call.
+     */
+    void setReadAhead(int blocks);
+    [[nodiscard]] int readAhead() const;
+
+    /*!
+     * Collects Statistics in the iterators created from now on, including those used by
+     * fileData(), extractTo() and the other convenience functions. Archive files are then read
+     * through callbacks instead of libarchive's own file handling, so that the I/O can be timed.
+     * A sequential device read by fromDevice() was already probed and is not read again; the
+     * first iterator's statistics start after that probe.
+     */
+    void setStatisticsEnabled(bool enabled);
+    [[nodiscard]] bool isStatisticsEnabled() const;
+
+    /*!
+     * Returns the sum of the statistics of the iterators closed since statistics were enabled.
+     * Copies of the reader made afterwards add to the same sum.
+     */
+    [[nodiscard]] Statistics statistics() const;
+
+    /*!
+     * Sets a callback receiving the statistics of each iterator created from now on when it is
+     * closed, while statistics are enabled. It is called on the thread closing the iterator,
+     * which for extractTo() may be a worker thread.
+     */
+    void setStatisticsCallback(StatisticsCallback callback);
+
     [[nodiscard]] ReaderIterator iterator() const;
 
+    /*!
+     * Reads all headers of the archive into a compact listing. Entry data is skipped by
+     * seeking wherever the input and compression allow it.
+     */
+    [[nodiscard]] ReaderListing list() const;
+
     [[nodiscard]] std::optional<QByteArray> fileData(const QString& pathName) const;
 
+    /*!
+     * Reads the data of all entries in \a pathNames in a single pass over the archive.
+     *
+     * The result is keyed by the cleaned path name. Paths that are not part of the archive
+     * are missing from the result.
+     */
+    [[nodiscard]] QHash<QString, QByteArray> filesData(const QStringList& pathNames) const;
+
+    /*!
+     * Streaming variant of filesData(const QStringList&).
+     *
+     * \a callback is invoked with the cleaned path name for every requested entry while the
+     * iterator is positioned on it, so the data can be consumed in chunks. The scan stops as
+     * soon as all requested paths have been seen.
+     *
+     * \returns true if all requested paths were found.
+     */
+    bool filesData(
+        const QStringList& pathNames,
+        const std::function<void(const QString& pathName, ReaderIterator& iterator)>& callback)
+        const;
+
+    /*!
+     * Hands the entries in \a pathNames, or all entries if it is empty, to \a sink on up to
+     * \a threads worker threads.
+     *
+     * Every worker opens its own handle and processes a contiguous range of entries, so
+     * \a sink is called concurrently and must be thread-safe. The iterator passed to it is
+     * positioned on the entry and may only be used inside the call. Returning false from
+     * \a sink stops the extraction.
+     *
+     * Entries can only be decompressed independently in zip archives and in uncompressed tar
+     * and cpio archives. Other archives, and archives read from a QIODevice, which the
+     * workers cannot share, are processed on the calling thread.
+     *
+     * Builds the index if needed.
+     *
+     * \returns true if all entries were found and \a sink returned true for each of them.
+     */
+    bool extractParallel(
+        const QStringList& pathNames,
+        const std::function<bool(const ReaderIndexEntry& entry, ReaderIterator& iterator)>& sink,
+        int threads = QThread::idealThreadCount());
+
+    /*!
+     * Extracts all entries into \a directory, which is created if needed.
+     *
+     * Files are streamed from the archive in blocks. Small files are written by a pool of I/O
+     * threads while decompression continues, see ExtractOptions. Permissions and modification
+     * times are restored, symbolic and hard links are recreated and other special files are
+     * skipped. Entries with absolute paths, paths leaving \a directory or paths below a
+     * symbolic link, including links already on disk, are not extracted. Existing files are
+     * replaced rather than written to, so links cannot redirect the data.
+     *
+     * \returns true if all entries were extracted.
+     */
+    bool extractTo(const QString& directory, const ExtractOptions& options = {}) const;
+
+    /*!
+     * Reads all headers of the archive once and records their position and metadata.
+     *
+     * Once the index is built, fileData() and indexEntry() no longer scan the archive for
+     * the path. For uncompressed tar and cpio archives fileData() seeks straight to the
+     * header of the requested entry instead of iterating. The index is discarded by open().
+     *
+     * \returns false if the archive could not be opened.
+     */
+    bool buildIndex();
+
+    [[nodiscard]] bool hasIndex() const;
+
+    /*!
+     * Returns the index entry for \a pathName, or std::nullopt if the archive does not contain
+     * it. Builds the index on first use.
+     */
+    [[nodiscard]] std::optional<ReaderIndexEntry> indexEntry(const QString& pathName);
+
+    /*!
+     * Batch variant of indexEntry(). Paths that are not part of the archive are omitted from
+     * the result, which is ordered by the position of the entries in the archive.
+     */
+    [[nodiscard]] QList<ReaderIndexEntry> indexEntries(const QStringList& pathNames);
+
 private:
+    enum class Source { File, Memory, Mapped, Device };
+
+    /*!
+     * Format and filters detected by the first iterator, guarded by \c mutex. Handles keep a
+     * reference, so it stays valid if the reader is destroyed or reset while they are open.
+     */
+    struct DetectedFormat
+    {
+        QMutex mutex;
+        int format{0};
+        QList<int> filters;
+    };
+
+    /*!
+     * State updated by const functions, guarded by \c mutex: the archive handle opened while
+     * probing the archive, waiting to be adopted by the first iterator, and the detected format.
+     * Copies of a Reader share the detected format but not the handle; they open their own.
+     */
+    class ProbeCache
+    {
+    public:
+        ProbeCache();
+        ProbeCache(const ProbeCache& other);
+        ~ProbeCache();
+
+        ProbeCache& operator=(const ProbeCache& rhs);
+
+        mutable QMutex mutex;
+        std::unique_ptr<ReaderIteratorPrivate> handle;
+        std::shared_ptr<DetectedFormat> detected;
+    };
+
+    Reader(
+        Source source,
+        QByteArray data,
+        QIODevice* device,
+        QList<SupportedFormat> supportedFormats,
+        QList<SupportedFilter> supportedFilters);
+
+    void probe();
+    void reset(Source source);
+
+    [[nodiscard]] std::optional<QByteArray> indexedFileData(const ReaderIndexEntry& entry) const;
+    [[nodiscard]] std::optional<ReaderIterator> indexedIterator(
+        const ReaderIndexEntry& entry) const;
+    [[nodiscard]] static std::optional<ReaderIndexEntry> makeIndexEntry(
+        const ReaderIterator& it, qint64 index);
+    [[nodiscard]] bool supportsParallelExtraction() const;
+    bool extractRange(
+        ReaderIterator& it,
+        qint64 position,
+        const QList<ReaderIndexEntry>& entries,
+        const std::function<bool(const ReaderIndexEntry& entry, ReaderIterator& iterator)>& sink,
+        const std::atomic<bool>& cancelled) const;
+
+    Source _source{Source::File};
     QString _fileName;
+    QByteArray _data;
+    QIODevice* _device{nullptr};
+    std::shared_ptr<std::atomic<bool>> _deviceInUse;
+    std::shared_ptr<QFile> _mappedFile;
+    const uchar* _mappedData{nullptr};
+    qint64 _mappedSize{0};
     QList<SupportedFormat> _supportedFormats{SupportedFormat::All};
     QList<SupportedFilter> _supportedFilters{SupportedFilter::All};
     qint64 _blockSize{10240};
+    int _readAheadBlocks{0};
+    std::shared_ptr<StatisticsAccumulator> _statistics;
+    StatisticsCallback _statisticsCallback;
     ReaderError _error{ReaderError::None};
     std::optional<qint64> _fileCount{std::nullopt};
+    bool _fileCountExact{false};
+    mutable ProbeCache _probe;
+    std::optional<QHash<QString, ReaderIndexEntry>> _index{std::nullopt};
+    bool _indexSeekable{false};
+    int _indexFormat{0};
 };
 } // namespace QtLibArchive
 
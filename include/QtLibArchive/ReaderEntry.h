@@ -4,10 +4,12 @@
 #ifndef QTLIBARCHIVE_READERENTRY_H
 #define QTLIBARCHIVE_READERENTRY_H
 
+#include <QtLibArchive/Digest.h>
 #include <QtLibArchive/QtLibArchive.h>
 
 #include <QDateTime>
 #include <QFile>
+#include <QList>
 
 #include <optional>
 
@@ -15,6 +17,13 @@ class archive;
 class archive_entry;
 
 namespace QtLibArchive {
+/*! A region of a sparse file that contains data. Everything outside these regions is a hole. */
+struct SparseRegion
+{
+    qint64 offset{0};
+    qint64 length{0};
+};
+
 class QTLIBARCHIVE_EXPORT ReaderEntry
 {
     friend class ReaderIterator;
@@ -34,6 +43,24 @@ public:
 
     [[nodiscard]] std::optional<qint64> size() const;
 
+    /*!
+     * Returns the data regions of a sparse file, or an empty list if the entry is not sparse
+     * or the format does not record holes.
+     */
+    [[nodiscard]] QList<SparseRegion> sparseRegions() const;
+
+    /*! Returns the earlier entry a hard link entry refers to. Such entries carry no data. */
+    [[nodiscard]] std::optional<QString> hardlink() const;
+
+    /*! Returns the target of a symbolic link entry. */
+    [[nodiscard]] std::optional<QString> symlink() const;
+
+    /*!
+     * Returns the digests Writer stored in the header of the entry, see
+     * WriterOptions::storeDigests.
+     */
+    [[nodiscard]] Digests storedDigests() const;
+
     [[nodiscard]] std::optional<QFile::Permissions> permissions() const;
 
     /*!
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_READERENTRYDEVICE_H
+#define QTLIBARCHIVE_READERENTRYDEVICE_H
+
+#include <QtLibArchive/QtLibArchive.h>
+
+#include <QIODevice>
+
+#include <optional>
+
+namespace QtLibArchive {
+class ReaderIterator;
+
+/*!
+ * Sequential, read-only QIODevice exposing the data of the current entry of a ReaderIterator.
+ *
+ * The device reads the entry in chunks as the consumer asks for data, so it can be handed to
+ * QXmlStreamReader, QImageReader, QTextStream etc. without materialising the entry in memory.
+ *
+ * The device is bound to the entry the iterator is positioned on when open() is called. Do
+ * not advance the iterator while the device is open.
+ */
+class QTLIBARCHIVE_EXPORT ReaderEntryDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit ReaderEntryDevice(ReaderIterator* iterator, QObject* parent = nullptr);
+    ~ReaderEntryDevice() override;
+
+    /*! Opens the device. Only QIODevice::ReadOnly (optionally with Text) is supported. */
+    bool open(OpenMode mode) override;
+    void close() override;
+
+    [[nodiscard]] bool isSequential() const override;
+    [[nodiscard]] bool atEnd() const override;
+
+    /*! Returns the size of the entry as stored in its header, or 0 if it is not known. */
+    [[nodiscard]] qint64 size() const override;
+    [[nodiscard]] qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    ReaderIterator* _iterator{nullptr};
+    std::optional<qint64> _entrySize{std::nullopt};
+    qint64 _consumed{0};
+    bool _finished{false};
+};
+} // namespace QtLibArchive
+
+#endif
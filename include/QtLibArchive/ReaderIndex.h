@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_READERINDEX_H
+#define QTLIBARCHIVE_READERINDEX_H
+
+#include <QtLibArchive/QtLibArchive.h>
+
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+
+#include <optional>
+
+namespace QtLibArchive {
+/*!
+ * Snapshot of a single archive header as recorded by Reader::buildIndex().
+ *
+ * Unlike ReaderEntry, an index entry owns its data and stays valid after the iterator that
+ * produced it has moved on.
+ */
+struct ReaderIndexEntry
+{
+    /*! The cleaned path name of the entry, as returned by ReaderEntry::cleanPathName(). */
+    QString pathName;
+
+    /*! Zero-based position of the header in the archive. */
+    qint64 index{-1};
+
+    /*! Offset of the header in the (decompressed) archive stream. */
+    qint64 headerOffset{-1};
+
+    FileType fileType{FileType::Unknown};
+    std::optional<qint64> size;
+    std::optional<QFile::Permissions> permissions;
+    std::optional<QDateTime> mtime;
+};
+} // namespace QtLibArchive
+
+#endif
@@ -4,10 +4,14 @@
 #ifndef QTLIBARCHIVE_READERITERATOR_H
 #define QTLIBARCHIVE_READERITERATOR_H
 
+#include <QtLibArchive/Digest.h>
 #include <QtLibArchive/QtLibArchive.h>
 #include <QtLibArchive/ReaderEntry.h>
+#include <QtLibArchive/Statistics.h>
 
+#include <QByteArray>
 #include <QFileDevice>
+#include <QList>
 
 #include <memory>
 #include <optional>
@@ -16,6 +20,20 @@ namespace QtLibArchive {
 class Reader;
 class ReaderIteratorPrivate;
 
+/*!
+ * A block of entry data as returned by ReaderIterator::readBlock().
+ *
+ * When returned by readBlock(), \c data does not own its memory. It stays valid until the next
+ * call to readBlock() or next() on the iterator.
+ */
+struct ReaderDataBlock
+{
+    QByteArray data;
+
+    /*! Offset of the block within the entry. Gaps between blocks are holes of zeros. */
+    qint64 offset{0};
+};
+
 class QTLIBARCHIVE_EXPORT ReaderIterator final
 {
     friend class Reader;
@@ -28,18 +46,82 @@ public:
     ReaderIterator& operator=(const ReaderIterator&) = delete;
     ReaderIterator& operator=(ReaderIterator&& rhs) noexcept;
 
+    /*!
+     * Advances to the next header. The data of the current entry is skipped, by seeking where
+     * the input allows it.
+     *
+     * Returns std::nullopt at the end of the archive. If the archive is truncated or corrupt,
+     * error() is set to ReaderError::CannotReadData.
+     */
     [[nodiscard]] std::optional<ReaderEntry> next();
     void close();
 
     [[nodiscard]] bool isValid() const;
+    /*!
+     * Reads up to \a maxSize bytes of the current entry, or the whole entry if \a maxSize is
+     * not given. Returns an empty array if the data cannot be read, see error().
+     */
     [[nodiscard]] QByteArray readData(std::optional<qint64> maxSize = std::nullopt) const;
 
+    /*!
+     * Reads up to \a maxSize bytes of the current entry into \a data.
+     *
+     * Fewer bytes are only returned at the end of the entry. Call it in a loop to process
+     * entries of any size with a fixed buffer.
+     *
+     * \returns the number of bytes read, 0 at the end of the entry or -1 on error.
+     */
+    qint64 readChunk(char* data, qint64 maxSize);
+
+    /*!
+     * Returns the next block of the current entry without copying it, or std::nullopt at the
+     * end of the entry or on error.
+     *
+     * Do not mix readBlock() with readData() or readChunk() on the same entry.
+     */
+    std::optional<ReaderDataBlock> readBlock();
+
+    /*!
+     * Reads the data regions of the current entry without the holes between them.
+     *
+     * For sparse files (see ReaderEntry::sparseRegions()) memory use then depends on the size
+     * of the data rather than on the size of the file. Adjacent blocks are merged. The blocks
+     * own their data.
+     */
+    [[nodiscard]] QList<ReaderDataBlock> readDataBlocks();
+
+    /*!
+     * Computes the digests in \a algorithms over the data of each entry as it is read with
+     * readData(), readChunk() or readBlock(), so verifying the data takes no second pass.
+     */
+    void setDigestAlgorithms(const QList<DigestAlgorithm>& algorithms);
+
+    /*!
+     * Returns the digests of the data of the current entry read so far. They cover the whole
+     * entry once it was read to the end.
+     */
+    [[nodiscard]] Digests digests() const;
+
+    /*!
+     * Returns the statistics of this iterator, if enabled with Reader::setStatisticsEnabled()
+     * before the iterator was created. After close() they are final.
+     */
+    [[nodiscard]] Statistics statistics() const;
+
     [[nodiscard]] ReaderError error() const;
 
     [[nodiscard]] ReaderEntry entry() const;
 
+    /*! Offset of the current header in the (decompressed) archive stream. */
+    [[nodiscard]] qint64 headerPosition() const;
+
 private:
-    ReaderIterator(const Reader* reader, qint64 blockSize);
+    ReaderIterator(
+        const Reader* reader, qint64 blockSize, qint64 startOffset = 0, int formatCode = 0);
+    explicit ReaderIterator(std::unique_ptr<ReaderIteratorPrivate> d);
+
+    [[nodiscard]] bool isSeekable() const;
+    [[nodiscard]] int formatCode() const;
 
     Q_DECLARE_PRIVATE(ReaderIterator);
     std::unique_ptr<ReaderIteratorPrivate> d_ptr;
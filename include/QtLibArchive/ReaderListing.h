@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_READERLISTING_H
+#define QTLIBARCHIVE_READERLISTING_H
+
+#include <QtLibArchive/QtLibArchive.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+
+#include <optional>
+#include <vector>
+
+class archive_entry;
+
+namespace QtLibArchive {
+/*!
+ * Compact record of a single header as collected by Reader::list().
+ *
+ * The path name is stored in the arena of the ReaderListing the record belongs to.
+ */
+struct QTLIBARCHIVE_EXPORT ReaderListEntry
+{
+    qint64 pathOffset{0};
+
+    /*! Size of the entry, or -1 if the header does not record it. */
+    qint64 size{-1};
+
+    /*! Modification time in milliseconds since the epoch, valid if hasMtime is set. */
+    qint64 mtimeMSecs{0};
+
+    quint32 pathLength{0};
+
+    /*! File type and permission bits as in st_mode. */
+    quint32 mode{0};
+
+    bool hasMtime{false};
+    bool hasPermissions{false};
+
+    [[nodiscard]] FileType fileType() const;
+    [[nodiscard]] std::optional<QFile::Permissions> permissions() const;
+    [[nodiscard]] std::optional<QDateTime> mtime() const;
+};
+
+/*!
+ * Owning snapshot of the headers of an archive.
+ *
+ * Unlike ReaderEntry, the records stay valid after the scan. All path names share one UTF-8
+ * arena, so a listing costs one record plus the path bytes per entry and no QString is created
+ * until a path is asked for.
+ */
+class QTLIBARCHIVE_EXPORT ReaderListing
+{
+    friend class Reader;
+
+public:
+    using const_iterator = std::vector<ReaderListEntry>::const_iterator;
+
+    [[nodiscard]] qint64 count() const;
+    [[nodiscard]] bool isEmpty() const;
+
+    /*! Returns false if the scan stopped at a corrupt or truncated header. */
+    [[nodiscard]] bool isComplete() const;
+
+    [[nodiscard]] const ReaderListEntry& at(qint64 index) const;
+
+    /*! Returns the UTF-8 path name of \a entry without copying it out of the arena. */
+    [[nodiscard]] QByteArray pathNameUtf8(const ReaderListEntry& entry) const;
+    [[nodiscard]] QString pathName(const ReaderListEntry& entry) const;
+    [[nodiscard]] QString cleanPathName(const ReaderListEntry& entry) const;
+
+    [[nodiscard]] const_iterator begin() const;
+    [[nodiscard]] const_iterator end() const;
+
+private:
+    void append(archive_entry* entry);
+    void squeeze();
+
+    QByteArray _paths;
+    std::vector<ReaderListEntry> _entries;
+    bool _complete{false};
+};
+} // namespace QtLibArchive
+
+#endif
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_STATISTICS_H
+#define QTLIBARCHIVE_STATISTICS_H
+
+#include <QtLibArchive/QtLibArchive.h>
+
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+namespace QtLibArchive {
+/*! Bytes that passed one stage of the filter chain, as reported by archive_filter_bytes(). */
+struct FilterStatistics
+{
+    /*! libarchive's name of the filter, e.g. "gzip", or "none" for the raw input/output. */
+    QString name;
+    qint64 bytes{0};
+};
+
+/*!
+ * Counters collected by a Reader, ReaderIterator or Writer when statistics are enabled.
+ *
+ * The times split the wall time into I/O, work inside libarchive and callbacks. What remains is
+ * spent in the caller's own code between calls, see callerNanoseconds().
+ */
+struct Statistics
+{
+    /*!
+     * Bytes per filter, starting with the uncompressed archive data and ending with the raw
+     * bytes read from or written to the file, device or memory.
+     */
+    QList<FilterStatistics> filters;
+
+    /*! Entry headers read or written. */
+    qint64 headers{0};
+
+    /*! Entries of a reader whose data was skipped rather than read. */
+    qint64 entriesSkipped{0};
+
+    /*!
+     * Time between enabling statistics, e.g. opening an iterator, and the last update.
+     */
+    qint64 elapsedNanoseconds{0};
+
+    /*! Time spent reading or writing the file, device or memory, or waiting for it. */
+    qint64 ioNanoseconds{0};
+
+    /*! Time spent in libarchive excluding I/O: decompressing, compressing and (de)serializing. */
+    qint64 codecNanoseconds{0};
+
+    /*! Time spent in callbacks provided by the caller, e.g. WriterOptions::compressionPolicy. */
+    qint64 callbackNanoseconds{0};
+
+    /*! Peak memory of the buffers held by the reader or writer itself. */
+    qint64 peakBufferBytes{0};
+
+    [[nodiscard]] qint64 callerNanoseconds() const
+    {
+        return elapsedNanoseconds - ioNanoseconds - codecNanoseconds - callbackNanoseconds;
+    }
+
+    /*! Adds the counters of \a other, e.g. to sum up the statistics of several iterators. */
+    Statistics& operator+=(const Statistics& other)
+    {
+        // Handles of the same archive have the same filter chain, so stages are matched by index.
+        for (int i = 0; i < other.filters.size(); ++i) {
+            if (i < filters.size() && filters.at(i).name == other.filters.at(i).name) {
+                filters[i].bytes += other.filters.at(i).bytes;
+            } else if (i >= filters.size()) {
+                filters.push_back(other.filters.at(i));
+            }
+        }
+
+        headers += other.headers;
+        entriesSkipped += other.entriesSkipped;
+        elapsedNanoseconds += other.elapsedNanoseconds;
+        ioNanoseconds += other.ioNanoseconds;
+        codecNanoseconds += other.codecNanoseconds;
+        callbackNanoseconds += other.callbackNanoseconds;
+        peakBufferBytes = qMax(peakBufferBytes, other.peakBufferBytes);
+
+        return *this;
+    }
+};
+
+/*! Called with the final statistics once a ReaderIterator or Writer is closed. */
+using StatisticsCallback = std::function<void(const Statistics& statistics)>;
+} // namespace QtLibArchive
+
+#endif
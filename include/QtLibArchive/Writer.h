@@ -6,8 +6,11 @@
 
 #include <QIODevice>
 #include <QString>
+#include <QStringList>
+#include <QThread>
 
 #include <QtLibArchive/WriterEntry.h>
+#include <QtLibArchive/WriterOptions.h>
 
 #include <memory>
 
@@ -30,11 +33,72 @@ public:
                | QFileDevice::ExeOther;
     }
 
-    explicit Writer(const QString& filePath, SupportedFormat format, SupportedFilter filter);
+    explicit Writer(
+        const QString& filePath,
+        SupportedFormat format,
+        SupportedFilter filter,
+        const WriterOptions& options = {});
+
+    /*!
+     * Creates a writer appending the archive to \a data, which is cleared first. The archive is
+     * complete once close() was called or the writer was destroyed. Archives that would exceed
+     * the maximum size of a QByteArray, about 2 GiB, fail with WriterError::CannotWriteData.
+     */
+    explicit Writer(
+        QByteArray* data,
+        SupportedFormat format,
+        SupportedFilter filter,
+        const WriterOptions& options = {});
+
+    /*!
+     * Creates a writer streaming the archive to \a device, e.g. a socket or a QProcess, as it is
+     * produced. The device is opened for writing if it is not open yet.
+     *
+     * While more than 1 MiB is waiting to be sent by a sequential device, the writer blocks
+     * until the device has written it, see WriterOptions::deviceWriteTimeout. close() flushes
+     * files, waits for sequential devices to write all data and leaves the device open. The
+     * caller keeps ownership of \a device.
+     */
+    explicit Writer(
+        QIODevice* device,
+        SupportedFormat format,
+        SupportedFilter filter,
+        const WriterOptions& options = {});
+
+    /*!
+     * Creates a writer compressing the archive with a chain of \a filters. They are applied in
+     * order, each one processing the output of the one before, e.g. {Zstd, Uu} writes a
+     * uuencoded .tar.zst. An empty list writes the archive uncompressed.
+     */
+    explicit Writer(
+        const QString& filePath,
+        SupportedFormat format,
+        const QList<SupportedFilter>& filters,
+        const WriterOptions& options = {});
+    explicit Writer(
+        QByteArray* data,
+        SupportedFormat format,
+        const QList<SupportedFilter>& filters,
+        const WriterOptions& options = {});
+    explicit Writer(
+        QIODevice* device,
+        SupportedFormat format,
+        const QList<SupportedFilter>& filters,
+        const WriterOptions& options = {});
+
     ~Writer();
 
     bool writeHeader(const WriterEntry& entry);
     bool writeData(const QByteArray& data);
+    bool writeData(const char* data, qint64 size);
+
+    /*!
+     * Writes the data of the current entry from \a device, up to the size given in its header.
+     * Sequential devices are waited for, see WriterOptions::deviceReadTimeout. Fails with
+     * WriterError::CannotWriteData if the device ends or times out before the entry is
+     * complete. Without a size in the header, everything up to the end of the device is
+     * written.
+     */
     bool writeData(QIODevice* device);
     bool finishEntry();
 
@@ -48,16 +112,72 @@ public:
         const QByteArray& data,
         QFileDevice::Permissions permissions = defaultRegularFilePermissions());
 
+    /*!
+     * Adds a hard link \a pathInArchive to the earlier entry \a target. The entry has no data
+     * of its own.
+     */
+    bool addHardlink(
+        const QString& pathInArchive,
+        const QString& target,
+        QFileDevice::Permissions permissions = defaultRegularFilePermissions());
+
+    /*!
+     * Adds the directory tree below \a rootPath with paths relative to it.
+     *
+     * The directories are listed and their entries stat'ed on up to \a threads threads, and
+     * file contents are read ahead of the thread writing the archive. Entries keep their file
+     * type, permissions and modification time. Symbolic links are stored as links and not
+     * followed. The entries of a directory follow it, sorted by name, so the archive does not
+     * depend on the order the file system lists them in. Files are stored the same way as with
+     * addFile(). Holes in sparse files are only detected in files over 16 MiB; smaller files
+     * are read ahead into memory and stored densely.
+     *
+     * \param nameFilters Wildcards like "*.cpp" files must match. Directories are not
+     *        filtered.
+     */
+    bool addTree(
+        const QString& rootPath,
+        const QStringList& nameFilters = {},
+        int threads = QThread::idealThreadCount());
+
     void close();
 
     [[nodiscard]] WriterError error() const;
+
+    /*!
+     * Returns the digests of the data written for the current entry so far, for the algorithms
+     * in WriterOptions::digestAlgorithms.
+     */
+    [[nodiscard]] Digests digests() const;
     [[nodiscard]] qint64 fileCount() const;
 
+    /*!
+     * Returns the statistics collected so far, if enabled with
+     * WriterOptions::collectStatistics. The filter byte counts are final after close().
+     */
+    [[nodiscard]] Statistics statistics() const;
+
+    /*!
+     * Returns whether \a head, the start of some data, looks like it is compressed already:
+     * either it starts with the signature of a compressed file format such as JPEG, PNG, MP4 or
+     * zip, or its bytes are close to uniformly distributed.
+     */
+    [[nodiscard]] static bool looksCompressed(const QByteArray& head);
+
     /*! Block size to read/write data in. This affects the behavior of addFile and writeData(QIODevice*). */
     [[nodiscard]] qint64 blockSize() const;
     void setBlockSize(qint64 blockSize);
 
 private:
+    friend class ParallelWriterPrivate;
+
+    /*!
+     * Writes a regular file. addFile(), addTree() and ParallelWriter all add files through
+     * these, so they are stored the same way.
+     */
+    bool writeFile(WriterEntry& entry, const QByteArray& data);
+    bool writeFile(WriterEntry& entry, QIODevice* device);
+
     Q_DECLARE_PRIVATE(Writer);
     std::unique_ptr<WriterPrivate> d_ptr;
 };
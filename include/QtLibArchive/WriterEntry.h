@@ -28,6 +28,19 @@ public:
     void setSize(qint64 size);
     void setPermissions(QFile::Permissions permissions);
 
+    /*!
+     * Marks \a length bytes at \a offset as data of a sparse file. Once a region is added,
+     * everything outside the regions is stored as a hole by formats that support it, like pax.
+     * The data written for the entry still covers the whole file including the holes.
+     */
+    void addSparseRegion(qint64 offset, qint64 length);
+
+    /*! Makes the entry a hard link to the earlier entry \a target. */
+    void setHardlink(const QString& target);
+
+    /*! Sets the target of a symbolic link entry. */
+    void setSymlink(const QString& target);
+
     /*! Set the last modified time of the entry.
      *  
      *  This method corresponds to libarchive's archive_entry_set_mtime.
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_WRITEROPTIONS_H
+#define QTLIBARCHIVE_WRITEROPTIONS_H
+
+#include <QtLibArchive/Digest.h>
+#include <QtLibArchive/QtLibArchive.h>
+#include <QtLibArchive/Statistics.h>
+
+#include <QList>
+#include <QString>
+
+#include <functional>
+#include <optional>
+
+namespace QtLibArchive {
+/*!
+ * A libarchive option in its raw form, as understood by archive_write_set_filter_option() and
+ * archive_write_set_format_option().
+ */
+struct WriterOption
+{
+    /*!
+     * Name of the filter or format the option is meant for, e.g. "zstd" or "zip". Empty
+     * applies to all.
+     */
+    QString module;
+    QString key;
+    QString value;
+};
+
+/*!
+ * Compression method for the entries of zip and 7z archives, which compress each entry
+ * themselves rather than through a filter. Which methods are available depends on the format
+ * and the libarchive version: zip supports Store and Deflate, 7z additionally Bzip2, Lzma,
+ * Lzma2 and Ppmd. Recent libarchive versions add further methods.
+ */
+enum class CompressionMethod { Store, Deflate, Bzip2, Lzma, Lzma2, Ppmd, Xz, Zstd };
+
+/*! How pax archives store extended attributes. */
+enum class PaxXattrHeader {
+    /*! Both the SCHILY.xattr and the LIBARCHIVE.xattr keywords, the libarchive default. */
+    All,
+    /*! Only SCHILY.xattr, as written by star and GNU tar. */
+    Schily,
+    /*! Only LIBARCHIVE.xattr. */
+    Libarchive
+};
+
+/*!
+ * Chooses the compression method of a zip entry from its path and \a head, the first block of
+ * its data. std::nullopt falls back to the built-in detection, see
+ * WriterOptions::storeIncompressible, and otherwise to WriterOptions::compressionMethod.
+ *
+ * libarchive only switches between CompressionMethod::Store and CompressionMethod::Deflate
+ * per entry. Any other method makes the Writer fail with WriterError::CannotSetFormatOption.
+ */
+using CompressionPolicy = std::function<std::optional<CompressionMethod>(
+    const QString& pathInArchive, const QByteArray& head)>;
+
+/*!
+ * Options applied to a Writer before the archive is opened.
+ *
+ * Options that do not apply to the filters in use are ignored, e.g. compressionThreads for
+ * gzip. A value a filter rejects makes the Writer fail with WriterError::CannotSetFilterOption.
+ */
+struct WriterOptions
+{
+    /*!
+     * Compression level. The valid range depends on the filter, e.g. 1-9 for gzip, bzip2 and
+     * xz or 1-22 for zstd.
+     */
+    std::optional<int> compressionLevel;
+
+    /*!
+     * Number of compression threads used by the xz and zstd filters. 0 lets the filter use
+     * one thread per CPU core.
+     */
+    std::optional<int> compressionThreads;
+
+    /*! Maximum lz4 block size as an lz4 block size id: 4 (64 KiB) to 7 (4 MiB). */
+    std::optional<int> lz4BlockSize;
+
+    /*! Further filter options, passed to archive_write_set_filter_option() verbatim. */
+    QList<WriterOption> filterOptions;
+
+    /*!
+     * Compression method of zip and 7z entries. Store suits data that is already compressed,
+     * e.g. media files, and costs no CPU time.
+     */
+    std::optional<CompressionMethod> compressionMethod;
+
+    /*! Level of the zip or 7z compression method, e.g. 0-9 for deflate. */
+    std::optional<int> compressionMethodLevel;
+
+    /*!
+     * Chooses the compression method per zip entry. It is consulted by Writer::addFile(),
+     * Writer::addTree() and ParallelWriter, which know the data before writing the header.
+     * 7z archives compress all entries as one stream and ignore it. Together with it or
+     * storeIncompressible, compressionMethod must be Store or Deflate.
+     */
+    CompressionPolicy compressionPolicy;
+
+    /*!
+     * Stores zip entries whose data already looks compressed, see Writer::looksCompressed(),
+     * instead of compressing them again. Applies to entries the compressionPolicy leaves open.
+     */
+    bool storeIncompressible{false};
+
+    /*!
+     * Whether zip archives use zip64 extensions. true always writes them, false never does,
+     * which limits entries to 4 GiB. By default they are written as needed.
+     */
+    std::optional<bool> zip64;
+
+    /*! Extended attribute keywords written to pax archives. */
+    std::optional<PaxXattrHeader> paxXattrHeader;
+
+    /*!
+     * Further format options, passed to archive_write_set_format_option() verbatim. A value
+     * the format rejects makes the Writer fail with WriterError::CannotSetFormatOption.
+     */
+    QList<WriterOption> formatOptions;
+
+    /*!
+     * Number of output blocks queued for a background thread that writes them to the file.
+     * The Writer then only waits for the disk while the queue is full. 0 writes every block on
+     * the calling thread.
+     */
+    int writeBehindBlocks{0};
+
+    /*! Flushes the file to disk (fdatasync) before Writer::close() returns. */
+    bool syncOnClose{false};
+
+    /*!
+     * Milliseconds Writer::writeData(QIODevice*) waits for a sequential device, e.g. a socket,
+     * to deliver more data. -1 waits forever.
+     */
+    int deviceReadTimeout{30000};
+
+    /*!
+     * Milliseconds a Writer streaming to a sequential device waits for it to send pending data
+     * before failing with WriterError::CannotWriteData. -1 waits forever.
+     */
+    int deviceWriteTimeout{30000};
+
+    /*!
+     * Digests computed over the data of each entry as it is written, see Writer::digests().
+     */
+    QList<DigestAlgorithm> digestAlgorithms;
+
+    /*!
+     * Stores the digests in the header of entries added with Writer::addFile(const QString&,
+     * const QByteArray&), Writer::addTree() or ParallelWriter, whose data is known before the
+     * header is written. They are stored as extended attributes, which pax archives keep, and
+     * read back with ReaderEntry::storedDigests(). Files addTree() streams because of their
+     * size are not covered.
+     */
+    bool storeDigests{false};
+
+    /*!
+     * Stores files added with Writer::addFile(), Writer::addTree() or ParallelWriter whose
+     * content was added before as hard links to the earlier entry. Only applies to tar
+     * formats. The content is identified by its SHA-256 digest; for devices it is read an
+     * extra time up front, sequential devices are not deduplicated.
+     */
+    bool deduplicate{false};
+
+    /*! Upper bound for the memory used to remember the content of earlier entries. */
+    qint64 deduplicationMemoryLimit{64 * 1024 * 1024};
+
+    /*!
+     * Collects Statistics, see Writer::statistics(). Files are then written through callbacks
+     * instead of libarchive's own file handling, so that the I/O can be timed.
+     */
+    bool collectStatistics{false};
+
+    /*!
+     * Called with the final statistics when the Writer is closed. Setting it also collects
+     * statistics.
+     */
+    StatisticsCallback statisticsCallback;
+};
+} // namespace QtLibArchive
+
+#endif
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include "DigestCalculator_p.h"
+
+#include <array>
+
+namespace QtLibArchive {
+namespace {
+const std::array<quint32, 256>& crc32Table()
+{
+    static const std::array<quint32, 256> Table = []() {
+        std::array<quint32, 256> table{};
+
+        for (quint32 i = 0; i < table.size(); ++i) {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+
+            table[i] = crc;
+        }
+
+        return table;
+    }();
+
+    return Table;
+}
+
+quint32 updateCrc32(quint32 crc, const char* data, qint64 size)
+{
+    const std::array<quint32, 256>& table = crc32Table();
+    crc = ~crc;
+
+    for (qint64 i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<quint8>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+QCryptographicHash::Algorithm hashAlgorithm(DigestAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case DigestAlgorithm::Md5:
+        return QCryptographicHash::Md5;
+    case DigestAlgorithm::Sha1:
+        return QCryptographicHash::Sha1;
+    case DigestAlgorithm::Sha512:
+        return QCryptographicHash::Sha512;
+    case DigestAlgorithm::Crc32:
+    case DigestAlgorithm::Sha256:
+        break;
+    }
+
+    return QCryptographicHash::Sha256;
+}
+} // namespace
+
+void DigestCalculator::setAlgorithms(const QList<DigestAlgorithm>& algorithms)
+{
+    _algorithms.clear();
+    _hashes.clear();
+    _crc32Enabled = false;
+
+    for (DigestAlgorithm algorithm : algorithms) {
+        if (_algorithms.contains(algorithm)) {
+            continue;
+        }
+
+        _algorithms.push_back(algorithm);
+
+        if (algorithm == DigestAlgorithm::Crc32) {
+            _crc32Enabled = true;
+        } else {
+            _hashes.push_back(std::make_unique<QCryptographicHash>(hashAlgorithm(algorithm)));
+        }
+    }
+
+    reset();
+}
+
+bool DigestCalculator::isEmpty() const
+{
+    return _algorithms.isEmpty();
+}
+
+void DigestCalculator::reset()
+{
+    _crc32 = 0;
+    _presetResult.reset();
+
+    for (const auto& hash : _hashes) {
+        hash->reset();
+    }
+}
+
+void DigestCalculator::addData(const char* data, qint64 size)
+{
+    if (_presetResult) {
+        return;
+    }
+
+    if (_crc32Enabled) {
+        _crc32 = updateCrc32(_crc32, data, size);
+    }
+
+    for (const auto& hash : _hashes) {
+        hash->addData(data, static_cast<int>(size));
+    }
+}
+
+void DigestCalculator::addZeros(qint64 size)
+{
+    if (isEmpty() || _presetResult) {
+        return;
+    }
+
+    static const QByteArray Zeros(64 * 1024, '\0');
+
+    while (size > 0) {
+        qint64 length = qMin<qint64>(size, Zeros.size());
+        addData(Zeros.constData(), length);
+        size -= length;
+    }
+}
+
+Digests DigestCalculator::result() const
+{
+    if (_presetResult) {
+        return *_presetResult;
+    }
+
+    Digests digests;
+    auto hash = _hashes.cbegin();
+
+    for (DigestAlgorithm algorithm : _algorithms) {
+        if (algorithm == DigestAlgorithm::Crc32) {
+            QByteArray crc(4, Qt::Uninitialized);
+            for (int i = 0; i < 4; ++i) {
+                crc[i] = static_cast<char>(_crc32 >> (24 - 8 * i));
+            }
+
+            digests.insert(algorithm, crc);
+        } else {
+            digests.insert(algorithm, (*hash++)->result());
+        }
+    }
+
+    return digests;
+}
+
+void DigestCalculator::setResult(const Digests& digests)
+{
+    _presetResult = digests;
+}
+
+const char* DigestCalculator::attributeName(DigestAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case DigestAlgorithm::Crc32:
+        return "user.qtlibarchive.crc32";
+    case DigestAlgorithm::Md5:
+        return "user.qtlibarchive.md5";
+    case DigestAlgorithm::Sha1:
+        return "user.qtlibarchive.sha1";
+    case DigestAlgorithm::Sha256:
+        return "user.qtlibarchive.sha256";
+    case DigestAlgorithm::Sha512:
+        return "user.qtlibarchive.sha512";
+    }
+
+    return "";
+}
+} // namespace QtLibArchive
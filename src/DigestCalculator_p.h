@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_DIGESTCALCULATOR_P_H
+#define QTLIBARCHIVE_DIGESTCALCULATOR_P_H
+
+#include <QtLibArchive/Digest.h>
+
+#include <QCryptographicHash>
+#include <QList>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace QtLibArchive {
+/*! Computes a set of digests over data passed in chunks. */
+class DigestCalculator final
+{
+public:
+    void setAlgorithms(const QList<DigestAlgorithm>& algorithms);
+    [[nodiscard]] bool isEmpty() const;
+
+    void reset();
+    void addData(const char* data, qint64 size);
+
+    /*! Adds \a size zero bytes, e.g. for the holes of sparse files. */
+    void addZeros(qint64 size);
+
+    [[nodiscard]] Digests result() const;
+
+    /*!
+     * Makes result() return \a digests computed beforehand. Data added until the next reset()
+     * is not hashed again.
+     */
+    void setResult(const Digests& digests);
+
+    /*! Name of the extended attribute Writer stores the digest of \a algorithm in. */
+    [[nodiscard]] static const char* attributeName(DigestAlgorithm algorithm);
+
+private:
+    QList<DigestAlgorithm> _algorithms;
+    std::vector<std::unique_ptr<QCryptographicHash>> _hashes;
+    bool _crc32Enabled{false};
+    quint32 _crc32{0};
+    std::optional<Digests> _presetResult;
+};
+} // namespace QtLibArchive
+
+#endif
@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include "Extractor_p.h"
+
+#include "FunctionRunnable_p.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace QtLibArchive {
+Extractor::Extractor(const QString& directory, const ExtractOptions& options)
+    : _root{QDir{directory}.absolutePath()}
+    , _options{options}
+{
+    _pool.setMaxThreadCount(qMax(options.threads, 1));
+}
+
+Extractor::~Extractor()
+{
+    // Pending jobs refer to this object.
+    _pool.waitForDone();
+}
+
+bool Extractor::extract(ReaderIterator& it)
+{
+    ReaderEntry entry = it.entry();
+    std::optional<QString> pathName = entry.pathName();
+    std::optional<QString> path = pathName ? targetPath(*pathName) : std::nullopt;
+
+    // Entries that would end up outside the directory are skipped. This includes entries
+    // below a symbolic link, extracted before or found on disk, which may point anywhere.
+    if (!path || isBelowSymlink(*path)) {
+        _failed = true;
+        return true;
+    }
+
+    if (path->isEmpty()) {
+        return true;
+    }
+
+    // An earlier entry with the same path must be written first, or it would win the race.
+    waitForPendingJob(*path);
+
+    // A later entry replaces a symbolic link instead of writing through it.
+    if (_symlinks.remove(*path)) {
+        QFile::remove(*path);
+    }
+
+    // Hard links have no data of their own and refer to an entry extracted before.
+    if (std::optional<QString> hardlink = entry.hardlink();
+        hardlink && entry.size().value_or(0) == 0) {
+        std::optional<QString> target = targetPath(*hardlink);
+
+        if (!target || target->isEmpty() || isBelowSymlink(*target)
+            || !extractHardlink(*path, *target)) {
+            _failed = true;
+        }
+
+        return true;
+    }
+
+    Metadata metadata{entry.permissions(), entry.mtime()};
+
+    switch (entry.fileType()) {
+    case FileType::Dir:
+        // A link existing on disk would make makePath() accept whatever directory it points to.
+        if (QFileInfo{*path}.isSymLink()) {
+            QFile::remove(*path);
+        }
+
+        if (makePath(*path)) {
+            _directories.push_back({*path, metadata});
+        } else {
+            _failed = true;
+        }
+
+        return true;
+    case FileType::Regular:
+        return extractFile(
+            it, *path, entry.size().value_or(-1), !entry.sparseRegions().isEmpty(), metadata);
+    case FileType::Link:
+        if (!extractSymlink(*path, entry.symlink().value_or(QString{}))) {
+            _failed = true;
+        }
+
+        return true;
+    default:
+        // Devices, fifos and sockets are not extracted.
+        return true;
+    }
+}
+
+bool Extractor::finish()
+{
+    _pool.waitForDone();
+
+    // Children come after their parents in the archive, so restore the deepest ones first.
+    for (auto it = _directories.crbegin(); it != _directories.crend(); ++it) {
+        if (_options.restorePermissions && it->metadata.permissions) {
+            QFile::setPermissions(it->path, *it->metadata.permissions);
+        }
+
+#ifdef Q_OS_UNIX
+        if (_options.restoreMtime && it->metadata.mtime) {
+            qint64 msecs = it->metadata.mtime->toMSecsSinceEpoch();
+            timespec times[2]{};
+            times[0].tv_nsec = UTIME_OMIT;
+            times[1].tv_sec = static_cast<time_t>(msecs / 1000);
+            times[1].tv_nsec = static_cast<long>(msecs % 1000) * 1000000;
+
+            utimensat(AT_FDCWD, QFile::encodeName(it->path).constData(), times, 0);
+        }
+#endif
+    }
+
+    _directories.clear();
+
+    QMutexLocker locker{&_mutex};
+    return !_failed && !_jobFailed;
+}
+
+std::optional<QString> Extractor::targetPath(const QString& pathName) const
+{
+    QString cleanPathName = QDir::cleanPath(pathName);
+
+    if (cleanPathName == QLatin1String(".")) {
+        return QString{};
+    }
+
+    if (QDir::isAbsolutePath(cleanPathName) || cleanPathName == QLatin1String("..")
+        || cleanPathName.startsWith(QLatin1String("../"))) {
+        return std::nullopt;
+    }
+
+    return _root.filePath(cleanPathName);
+}
+
+bool Extractor::makePath(const QString& path)
+{
+    // Most entries share their parent with the previous one, so each directory is only
+    // created once.
+    if (_createdPaths.contains(path)) {
+        return true;
+    }
+
+    if (!QDir{}.mkpath(path)) {
+        return false;
+    }
+
+    _createdPaths.insert(path);
+    return true;
+}
+
+bool Extractor::extractFile(
+    ReaderIterator& it, const QString& path, qint64 size, bool sparse, Metadata metadata)
+{
+    if (!makePath(QFileInfo{path}.path())) {
+        _failed = true;
+        return true;
+    }
+
+    if (!sparse && size >= 0 && size <= _options.smallFileSize) {
+        QByteArray data = it.readData();
+
+        if (data.size() != size) {
+            return false;
+        }
+
+        submit(path, size, [this, path, data, metadata]() {
+            QFile file{path};
+            return openFile(file, data.size()) && file.write(data) == data.size()
+                   && restoreMetadata(file, metadata);
+        });
+
+        return true;
+    }
+
+    // Holes of sparse files are not allocated, so they must not be preallocated either.
+    QFile file{path};
+    if (!openFile(file, sparse ? 0 : size)) {
+        _failed = true;
+        return true;
+    }
+
+    // libarchive's blocks are written directly. Gaps between them are holes, which are
+    // skipped by seeking instead of writing zeros.
+    while (std::optional<ReaderDataBlock> block = it.readBlock()) {
+        if (block->offset != file.pos() && !file.seek(block->offset)) {
+            _failed = true;
+            return true;
+        }
+
+        if (file.write(block->data) != block->data.size()) {
+            _failed = true;
+            return true;
+        }
+    }
+
+    if (it.error() != ReaderError::None) {
+        return false;
+    }
+
+    // A hole at the end of the file.
+    if (size > file.pos() && !file.resize(size)) {
+        _failed = true;
+    }
+
+    if (!restoreMetadata(file, metadata)) {
+        _failed = true;
+    }
+
+    return true;
+}
+
+bool Extractor::extractSymlink(const QString& path, const QString& target)
+{
+    if (target.isEmpty() || !makePath(QFileInfo{path}.path())) {
+        return false;
+    }
+
+    // Files still waiting for an I/O thread are written before the link can redirect them.
+    _pool.waitForDone();
+    QFile::remove(path);
+    _symlinks.insert(path);
+
+    return QFile::link(target, path);
+}
+
+bool Extractor::extractHardlink(const QString& path, const QString& target)
+{
+    if (!makePath(QFileInfo{path}.path())) {
+        return false;
+    }
+
+    // The target may still be waiting for an I/O thread.
+    _pool.waitForDone();
+    QFile::remove(path);
+
+#ifdef Q_OS_UNIX
+    return ::link(QFile::encodeName(target).constData(), QFile::encodeName(path).constData())
+           == 0;
+#else
+    return QFile::copy(target, path);
+#endif
+}
+
+bool Extractor::isBelowSymlink(const QString& path) const
+{
+    for (QString parent = QFileInfo{path}.path(); parent.size() > _root.path().size();
+         parent = QFileInfo{parent}.path()) {
+        if (_symlinks.contains(parent)) {
+            return true;
+        }
+
+        // Directories created by makePath() were checked before, including their parents.
+        if (_createdPaths.contains(parent)) {
+            return false;
+        }
+
+        // Links may also exist on disk already, e.g. from an earlier extraction.
+        if (QFileInfo{parent}.isSymLink()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Extractor::submit(const QString& path, qint64 size, std::function<bool()> job)
+{
+    {
+        QMutexLocker locker{&_mutex};
+
+        while (_pendingBytes > 0 && _pendingBytes + size > _options.maxPendingBytes) {
+            _jobFinished.wait(&_mutex);
+        }
+
+        _pendingBytes += size;
+        _pendingPaths.insert(path);
+    }
+
+    _pool.start(new FunctionRunnable{[this, path, size, job = std::move(job)]() {
+        bool ok = job();
+
+        QMutexLocker locker{&_mutex};
+        _pendingBytes -= size;
+        _pendingPaths.remove(path);
+        _jobFailed = _jobFailed || !ok;
+        _jobFinished.wakeAll();
+    }});
+}
+
+void Extractor::waitForPendingJob(const QString& path)
+{
+    QMutexLocker locker{&_mutex};
+
+    while (_pendingPaths.contains(path)) {
+        _jobFinished.wait(&_mutex);
+    }
+}
+
+bool Extractor::openFile(QFile& file, qint64 size) const
+{
+    // The file is replaced rather than truncated. It may be a symbolic or hard link, placed by
+    // an earlier entry or by someone else, and writing through it could change any file.
+    QFile::remove(file.fileName());
+
+#ifdef Q_OS_UNIX
+    int fd = ::open(
+        QFile::encodeName(file.fileName()).constData(),
+        O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+        0666);
+
+    if (fd < 0 || !file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle)) {
+        return false;
+    }
+#else
+    if (!file.open(QIODevice::WriteOnly | QIODevice::NewOnly)) {
+        return false;
+    }
+#endif
+
+#ifdef Q_OS_LINUX
+    // Reserving the space up front avoids fragmentation and repeated block allocation. It is
+    // only a hint, so failures are ignored.
+    if (_options.preallocate && size > 0) {
+        (void)posix_fallocate(file.handle(), 0, static_cast<off_t>(size));
+    }
+#else
+    Q_UNUSED(size);
+#endif
+
+    return true;
+}
+
+bool Extractor::restoreMetadata(QFile& file, const Metadata& metadata) const
+{
+    // Data still buffered by QFile would change the modification time when it is written.
+    bool ok = file.flush();
+
+    if (_options.restorePermissions && metadata.permissions) {
+        ok = file.setPermissions(*metadata.permissions) && ok;
+    }
+
+    if (_options.restoreMtime && metadata.mtime) {
+        ok = file.setFileTime(*metadata.mtime, QFileDevice::FileModificationTime) && ok;
+    }
+
+    return ok;
+}
+} // namespace QtLibArchive
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_EXTRACTOR_P_H
+#define QTLIBARCHIVE_EXTRACTOR_P_H
+
+#include <QtLibArchive/ExtractOptions.h>
+#include <QtLibArchive/ReaderIterator.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <functional>
+#include <optional>
+
+namespace QtLibArchive {
+/*!
+ * Writes the entries of an archive below a directory.
+ *
+ * Entries are passed in by the decompressing thread. Small files are handed to a pool of I/O
+ * threads together with their data, so decompression continues while they are written.
+ */
+class Extractor final
+{
+public:
+    Extractor(const QString& directory, const ExtractOptions& options);
+    Extractor(const Extractor&) = delete;
+    ~Extractor();
+
+    Extractor& operator=(const Extractor&) = delete;
+
+    /*! Extracts the entry \a it is positioned on. Returns false if extraction must stop. */
+    bool extract(ReaderIterator& it);
+
+    /*!
+     * Waits for the I/O threads and restores the metadata of directories, which writing their
+     * contents changed.
+     *
+     * \returns false if any entry could not be extracted.
+     */
+    bool finish();
+
+private:
+    struct Metadata
+    {
+        std::optional<QFile::Permissions> permissions;
+        std::optional<QDateTime> mtime;
+    };
+
+    struct DirectoryMetadata
+    {
+        QString path;
+        Metadata metadata;
+    };
+
+    [[nodiscard]] std::optional<QString> targetPath(const QString& pathName) const;
+    bool makePath(const QString& path);
+    bool extractFile(
+        ReaderIterator& it, const QString& path, qint64 size, bool sparse, Metadata metadata);
+    bool extractSymlink(const QString& path, const QString& target);
+    bool extractHardlink(const QString& path, const QString& target);
+    [[nodiscard]] bool isBelowSymlink(const QString& path) const;
+
+    /*!
+     * Runs \a job writing \a path on the I/O threads, once less than maxPendingBytes are
+     * waiting.
+     */
+    void submit(const QString& path, qint64 size, std::function<bool()> job);
+
+    /*! Waits until the job writing \a path, if any, has finished. */
+    void waitForPendingJob(const QString& path);
+
+    bool openFile(QFile& file, qint64 size) const;
+    bool restoreMetadata(QFile& file, const Metadata& metadata) const;
+
+    QDir _root;
+    ExtractOptions _options;
+    QSet<QString> _createdPaths;
+    QSet<QString> _symlinks;
+    QList<DirectoryMetadata> _directories;
+    bool _failed{false};
+
+    QThreadPool _pool;
+    QMutex _mutex;
+    QWaitCondition _jobFinished;
+    qint64 _pendingBytes{0};
+    QSet<QString> _pendingPaths;
+    bool _jobFailed{false};
+};
+} // namespace QtLibArchive
+
+#endif
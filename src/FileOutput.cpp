@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include "FileOutput_p.h"
+
+#include "FunctionRunnable_p.h"
+
+#include <QMutexLocker>
+
+#include <cstring>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+namespace QtLibArchive {
+FileOutput::FileOutput(const QString& filePath, int depth, bool syncOnClose)
+    : _file{filePath}
+    , _depth{static_cast<size_t>(qMax(depth, 0))}
+    , _syncOnClose{syncOnClose}
+{
+    _pool.setMaxThreadCount(1);
+}
+
+FileOutput::~FileOutput()
+{
+    close();
+}
+
+bool FileOutput::open()
+{
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    if (_depth > 0) {
+        _pool.start(new FunctionRunnable{[this]() { drain(); }});
+    }
+
+    return true;
+}
+
+bool FileOutput::write(const char* data, qint64 size)
+{
+    if (_depth == 0) {
+        _failed = _failed || _file.write(data, size) != size;
+        return !_failed;
+    }
+
+    QMutexLocker locker{&_mutex};
+
+    while (!_failed && _queue.size() >= _depth) {
+        _queueNotFull.wait(&_mutex);
+    }
+
+    if (_failed) {
+        return false;
+    }
+
+    // libarchive reuses its buffer, so the block is copied. Blocks that were written already
+    // are recycled to avoid an allocation per block.
+    QByteArray block;
+    if (!_spare.empty()) {
+        block = std::move(_spare.back());
+        _spare.pop_back();
+    }
+
+    locker.unlock();
+    block.resize(static_cast<int>(size));
+    std::memcpy(block.data(), data, static_cast<size_t>(size));
+    locker.relock();
+
+    _queue.push_back(std::move(block));
+    _queueNotEmpty.wakeAll();
+
+    return true;
+}
+
+bool FileOutput::close()
+{
+    if (!_file.isOpen()) {
+        return !_failed;
+    }
+
+    {
+        QMutexLocker locker{&_mutex};
+        _closing = true;
+        _queueNotEmpty.wakeAll();
+    }
+
+    _pool.waitForDone();
+
+    _failed = _failed || !_file.flush() || (_syncOnClose && !sync());
+    _file.close();
+
+    return !_failed;
+}
+
+QString FileOutput::errorString() const
+{
+    return _file.errorString();
+}
+
+void FileOutput::drain()
+{
+    QMutexLocker locker{&_mutex};
+
+    for (;;) {
+        while (_queue.empty() && !_closing) {
+            _queueNotEmpty.wait(&_mutex);
+        }
+
+        if (_queue.empty()) {
+            return;
+        }
+
+        QByteArray block = std::move(_queue.front());
+        _queue.pop_front();
+
+        // After a failure the queue is still drained, so producers do not block forever.
+        if (!_failed) {
+            locker.unlock();
+            bool ok = _file.write(block) == block.size();
+            locker.relock();
+
+            _failed = _failed || !ok;
+        }
+
+        _spare.push_back(std::move(block));
+        _queueNotFull.wakeAll();
+    }
+}
+
+bool FileOutput::sync()
+{
+#if defined(Q_OS_LINUX)
+    return ::fdatasync(_file.handle()) == 0;
+#elif defined(Q_OS_UNIX)
+    return ::fsync(_file.handle()) == 0;
+#elif defined(Q_OS_WIN)
+    return ::_commit(_file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+} // namespace QtLibArchive
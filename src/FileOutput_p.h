@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_FILEOUTPUT_P_H
+#define QTLIBARCHIVE_FILEOUTPUT_P_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <deque>
+#include <vector>
+
+namespace QtLibArchive {
+/*!
+ * Output file of a Writer, used instead of libarchive's own file handling when blocks are
+ * written behind on a background thread or the file is synced on close.
+ *
+ * With a write-behind depth of 0, blocks are written on the calling thread. Otherwise they are
+ * copied into a queue of at most \c depth blocks, which an I/O thread drains. write() then only
+ * blocks while the queue is full.
+ */
+class FileOutput final
+{
+public:
+    FileOutput(const QString& filePath, int depth, bool syncOnClose);
+    FileOutput(const FileOutput&) = delete;
+    ~FileOutput();
+
+    FileOutput& operator=(const FileOutput&) = delete;
+
+    bool open();
+
+    /*! Queues or writes \a size bytes. Returns false if writing failed, possibly earlier. */
+    bool write(const char* data, qint64 size);
+
+    /*! Writes all queued blocks, syncs the file if requested and closes it. */
+    bool close();
+
+    [[nodiscard]] QString errorString() const;
+
+private:
+    void drain();
+    bool sync();
+
+    QFile _file;
+    size_t _depth{0};
+    bool _syncOnClose{false};
+    bool _closing{false};
+    bool _failed{false};
+    std::deque<QByteArray> _queue;
+    std::vector<QByteArray> _spare;
+
+    QThreadPool _pool;
+    QMutex _mutex;
+    QWaitCondition _queueNotEmpty;
+    QWaitCondition _queueNotFull;
+};
+} // namespace QtLibArchive
+
+#endif
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_FUNCTIONRUNNABLE_P_H
+#define QTLIBARCHIVE_FUNCTIONRUNNABLE_P_H
+
+#include <QRunnable>
+
+#include <functional>
+
+namespace QtLibArchive {
+/*! QRunnable running a std::function, for Qt versions without QRunnable::create(). */
+class FunctionRunnable final : public QRunnable
+{
+public:
+    explicit FunctionRunnable(std::function<void()> function)
+        : _function{std::move(function)}
+    {}
+
+    void run() override { _function(); }
+
+private:
+    std::function<void()> _function;
+};
+} // namespace QtLibArchive
+
+#endif
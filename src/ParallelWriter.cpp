@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include <QtLibArchive/ParallelWriter.h>
+
+#include "FunctionRunnable_p.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <deque>
+
+namespace QtLibArchive {
+class ParallelWriterPrivate
+{
+    friend class ParallelWriter;
+
+public:
+    struct Job
+    {
+        std::unique_ptr<WriterEntry> entry;
+        std::function<std::optional<QByteArray>()> loadData;
+        std::optional<QByteArray> data;
+        qint64 pendingBytes{0};
+        bool done{false};
+    };
+
+    ParallelWriterPrivate(Writer* writer, int threads, qint64 maxPendingBytes)
+        : _writer{writer}
+        , _maxPendingBytes{maxPendingBytes}
+        , _maxJobs{static_cast<size_t>(qMax(threads, 1)) * 4}
+    {
+        Q_ASSERT(writer != nullptr);
+        _pool.setMaxThreadCount(qMax(threads, 1));
+    }
+
+    /*!
+     * Commits finished jobs in order. With \a wait, blocks until the first job is done
+     * instead of returning when it is not.
+     */
+    bool commit(bool wait)
+    {
+        QMutexLocker locker{&_mutex};
+
+        while (!_jobs.empty()) {
+            std::shared_ptr<Job> job = _jobs.front();
+
+            if (!job->done) {
+                if (!wait) {
+                    break;
+                }
+
+                _jobDone.wait(&_mutex);
+                continue;
+            }
+
+            _jobs.pop_front();
+            _pendingBytes -= job->pendingBytes;
+
+            // Workers only touch jobs that are not done yet, so the lock is not needed while
+            // writing.
+            locker.unlock();
+            bool ok = write(*job);
+            locker.relock();
+
+            if (!ok) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*!
+     * Queues \a entry, reserving \a expectedBytes for its payload until it is loaded. The
+     * reservation is corrected to the actual size afterwards.
+     */
+    bool enqueue(
+        WriterEntry entry,
+        std::function<std::optional<QByteArray>()> loadData,
+        qint64 expectedBytes)
+    {
+        if (_error != WriterError::None || !commit(false)) {
+            return false;
+        }
+
+        auto job = std::make_shared<Job>();
+        job->entry = std::make_unique<WriterEntry>(std::move(entry));
+        job->loadData = std::move(loadData);
+        job->pendingBytes = job->loadData ? expectedBytes : 0;
+
+        {
+            QMutexLocker locker{&_mutex};
+
+            // Bound both the payloads waiting to be committed and the number of jobs that may
+            // still load by committing before queueing more.
+            while (!_jobs.empty()
+                   && ((_pendingBytes > 0 && _pendingBytes + job->pendingBytes > _maxPendingBytes)
+                       || _jobs.size() >= _maxJobs)) {
+                if (!_jobs.front()->done) {
+                    _jobDone.wait(&_mutex);
+                    continue;
+                }
+
+                locker.unlock();
+                bool ok = commit(false);
+                locker.relock();
+
+                if (!ok) {
+                    return false;
+                }
+            }
+
+            job->done = !job->loadData;
+            _pendingBytes += job->pendingBytes;
+            _jobs.push_back(job);
+        }
+
+        if (job->loadData) {
+            _pool.start(new FunctionRunnable{[this, job]() {
+                std::optional<QByteArray> data = job->loadData();
+                qint64 loadedBytes = data ? data->size() : 0;
+
+                QMutexLocker locker{&_mutex};
+                _pendingBytes += loadedBytes - job->pendingBytes;
+                job->pendingBytes = loadedBytes;
+                job->data = std::move(data);
+                job->done = true;
+                _jobDone.wakeAll();
+            }});
+        }
+
+        return true;
+    }
+
+    bool write(Job& job)
+    {
+        if (_error != WriterError::None) {
+            return false;
+        }
+
+        if (job.loadData && !job.data) {
+            _error = WriterError::CannotOpenFile;
+            return false;
+        }
+
+        bool ok = false;
+
+        if (job.data && job.entry->fileType() == FileType::Regular) {
+            ok = _writer->writeFile(*job.entry, *job.data);
+        } else if (job.data) {
+            job.entry->setSize(job.data->size());
+            ok = _writer->writeHeader(*job.entry)
+                 && _writer->writeData(job.data->constData(), job.data->size());
+        } else {
+            ok = _writer->writeHeader(*job.entry);
+        }
+
+        if (!ok) {
+            _error = _writer->error();
+        }
+
+        return ok;
+    }
+
+    Writer* _writer{nullptr};
+    qint64 _maxPendingBytes{0};
+    size_t _maxJobs{0};
+    qint64 _pendingBytes{0};
+    WriterError _error{WriterError::None};
+
+    QThreadPool _pool;
+    QMutex _mutex;
+    QWaitCondition _jobDone;
+    std::deque<std::shared_ptr<Job>> _jobs;
+};
+
+ParallelWriter::ParallelWriter(Writer* writer, int threads, qint64 maxPendingBytes)
+    : d_ptr{new ParallelWriterPrivate{writer, threads, maxPendingBytes}}
+{}
+
+ParallelWriter::~ParallelWriter()
+{
+    finish();
+}
+
+bool ParallelWriter::addFile(
+    const QString& pathInArchive,
+    const QString& sourceFilePath,
+    QFileDevice::Permissions permissions)
+{
+    WriterEntry entry;
+    entry.setFileType(FileType::Regular);
+    entry.setPathName(pathInArchive);
+    entry.setPermissions(permissions);
+
+    return addFile(std::move(entry), sourceFilePath);
+}
+
+bool ParallelWriter::addFile(WriterEntry entry, const QString& sourceFilePath)
+{
+    Q_D(ParallelWriter);
+
+    auto loadData = [sourceFilePath]() -> std::optional<QByteArray> {
+        QFile file{sourceFilePath};
+
+        if (!file.open(QIODevice::ReadOnly)) {
+            return std::nullopt;
+        }
+
+        return file.readAll();
+    };
+
+    return d->enqueue(std::move(entry), std::move(loadData), QFileInfo{sourceFilePath}.size());
+}
+
+bool ParallelWriter::addEntry(
+    WriterEntry entry, std::function<std::optional<QByteArray>()> loadData)
+{
+    Q_D(ParallelWriter);
+    return d->enqueue(std::move(entry), std::move(loadData), 0);
+}
+
+bool ParallelWriter::finish()
+{
+    Q_D(ParallelWriter);
+
+    bool ok = d->commit(true);
+    d->_pool.waitForDone();
+
+    // Jobs that were still loading when a commit failed are discarded.
+    QMutexLocker locker{&d->_mutex};
+    d->_jobs.clear();
+    d->_pendingBytes = 0;
+
+    return ok && d->_error == WriterError::None;
+}
+
+WriterError ParallelWriter::error() const
+{
+    Q_D(const ParallelWriter);
+    return d->_error;
+}
+} // namespace QtLibArchive
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_PERMISSIONS_P_H
+#define QTLIBARCHIVE_PERMISSIONS_P_H
+
+#include <QFileDevice>
+#include <QList>
+#include <QPair>
+
+#include <sys/stat.h>
+
+namespace QtLibArchive {
+/*! Converts the permission bits of \a mode to Qt's permissions. */
+inline QFileDevice::Permissions permissionsFromMode(quint32 mode)
+{
+    QFileDevice::Permissions permissions{};
+
+    static const QList<QPair<int, QFileDevice::Permission>> Mapping{
+        {S_IRUSR, QFileDevice::ReadOwner},
+        {S_IWUSR, QFileDevice::WriteOwner},
+        {S_IXUSR, QFileDevice::ExeOwner},
+        {S_IRGRP, QFileDevice::ReadGroup},
+        {S_IWGRP, QFileDevice::WriteGroup},
+        {S_IXGRP, QFileDevice::ExeGroup},
+        {S_IROTH, QFileDevice::ReadOther},
+        {S_IWOTH, QFileDevice::WriteOther},
+        {S_IXOTH, QFileDevice::ExeOther}};
+
+    for (auto [mask, permission] : Mapping) {
+        if (mode & mask) {
+            permissions |= permission;
+        }
+    }
+
+    return permissions;
+}
+} // namespace QtLibArchive
+
+#endif
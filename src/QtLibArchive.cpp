@@ -21,6 +21,8 @@ constexpr const char* readerErrorStr(ReaderError readerError)
         return "CannotOpenFile";
     case ReaderError::CannotReadData:
         return "CannotReadData";
+    case ReaderError::DeviceInUse:
+        return "DeviceInUse";
     }
 
     return "";
@@ -45,6 +47,10 @@ constexpr const char* writerErrorStr(WriterError writerError)
         return "CannotWriteData";
     case WriterError::InvalidEntry:
         return "InvalidEntry";
+    case WriterError::CannotSetFilterOption:
+        return "CannotSetFilterOption";
+    case WriterError::CannotSetFormatOption:
+        return "CannotSetFormatOption";
     }
 
     return "";
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include "ReadAheadBuffer_p.h"
+
+#include "FunctionRunnable_p.h"
+
+#include <QMutexLocker>
+
+namespace QtLibArchive {
+ReadAheadBuffer::ReadAheadBuffer(QIODevice* device, qint64 blockSize, int depth)
+    : _device{device}
+    , _size{device->size()}
+    , _sequential{device->isSequential()}
+    , _slots(static_cast<size_t>(qMax(depth, 2)))
+    , _position{device->pos()}
+{
+    Q_ASSERT(device != nullptr);
+
+    for (Slot& slot : _slots) {
+        slot.data.resize(blockSize);
+    }
+
+    _pool.setMaxThreadCount(1);
+    start();
+}
+
+ReadAheadBuffer::~ReadAheadBuffer()
+{
+    stop();
+}
+
+qint64 ReadAheadBuffer::read(const char** data)
+{
+    QMutexLocker locker{&_mutex};
+
+    // The block handed out by the previous call is no longer in use.
+    if (_holding) {
+        _readIndex = (_readIndex + 1) % _slots.size();
+        _filled--;
+        _holding = false;
+        _spaceAvailable.wakeAll();
+    }
+
+    while (_filled == 0) {
+        _dataAvailable.wait(&_mutex);
+    }
+
+    const Slot& slot = _slots[_readIndex];
+
+    // The end of the device or an error stays in the ring, so it is reported again.
+    if (slot.size <= 0) {
+        return slot.size;
+    }
+
+    _holding = true;
+    _position += slot.size;
+    *data = slot.data.constData();
+
+    return slot.size;
+}
+
+bool ReadAheadBuffer::seek(qint64 position)
+{
+    stop();
+
+    _readIndex = 0;
+    _writeIndex = 0;
+    _filled = 0;
+    _holding = false;
+
+    bool ok = _device->seek(position);
+    _position = _device->pos();
+    _size = _device->size();
+    _errorString.clear();
+
+    start();
+    return ok;
+}
+
+qint64 ReadAheadBuffer::pos() const
+{
+    QMutexLocker locker{&_mutex};
+    return _position;
+}
+
+qint64 ReadAheadBuffer::size() const
+{
+    return _size;
+}
+
+bool ReadAheadBuffer::isSequential() const
+{
+    return _sequential;
+}
+
+QString ReadAheadBuffer::errorString() const
+{
+    QMutexLocker locker{&_mutex};
+    return _errorString;
+}
+
+void ReadAheadBuffer::start()
+{
+    _stopping = false;
+    _pool.start(new FunctionRunnable{[this]() { fill(); }});
+}
+
+void ReadAheadBuffer::stop()
+{
+    {
+        QMutexLocker locker{&_mutex};
+        _stopping = true;
+        _spaceAvailable.wakeAll();
+    }
+
+    _pool.waitForDone();
+}
+
+void ReadAheadBuffer::fill()
+{
+    QMutexLocker locker{&_mutex};
+
+    for (;;) {
+        while (!_stopping && _filled == _slots.size()) {
+            _spaceAvailable.wait(&_mutex);
+        }
+
+        if (_stopping) {
+            return;
+        }
+
+        // The consumer does not touch slots that are not filled yet, so the device is read
+        // without holding the lock.
+        Slot& slot = _slots[_writeIndex];
+        locker.unlock();
+        slot.size = _device->read(slot.data.data(), slot.data.size());
+        QString errorString = slot.size < 0 ? _device->errorString() : QString{};
+        locker.relock();
+
+        if (slot.size < 0) {
+            _errorString = errorString;
+        }
+
+        _writeIndex = (_writeIndex + 1) % _slots.size();
+        _filled++;
+        _dataAvailable.wakeAll();
+
+        if (slot.size <= 0) {
+            return;
+        }
+    }
+}
+} // namespace QtLibArchive
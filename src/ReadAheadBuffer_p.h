@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_READAHEADBUFFER_P_H
+#define QTLIBARCHIVE_READAHEADBUFFER_P_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <vector>
+
+namespace QtLibArchive {
+/*!
+ * Reads blocks of a device ahead of time on a background thread.
+ *
+ * The blocks are kept in a ring buffer of \c depth slots. The block returned by read() stays
+ * valid until the next call to read() or seek(), which matches what libarchive expects from a
+ * read callback. The device must not be used by anyone else while the buffer exists.
+ */
+class ReadAheadBuffer final
+{
+public:
+    ReadAheadBuffer(QIODevice* device, qint64 blockSize, int depth);
+    ReadAheadBuffer(const ReadAheadBuffer&) = delete;
+    ~ReadAheadBuffer();
+
+    ReadAheadBuffer& operator=(const ReadAheadBuffer&) = delete;
+
+    /*!
+     * Waits for the next block and points \a data to it.
+     *
+     * \returns the size of the block, 0 at the end of the device or -1 on error.
+     */
+    qint64 read(const char** data);
+
+    /*! Discards the blocks read ahead and continues reading at \a position. */
+    bool seek(qint64 position);
+
+    /*! Position of the end of the last block returned by read(). */
+    [[nodiscard]] qint64 pos() const;
+
+    // The device is busy on the background thread, so these return values taken from it
+    // while it is not.
+    [[nodiscard]] qint64 size() const;
+    [[nodiscard]] bool isSequential() const;
+    [[nodiscard]] QString errorString() const;
+
+private:
+    struct Slot
+    {
+        QByteArray data;
+        qint64 size{0};
+    };
+
+    void start();
+    void stop();
+    void fill();
+
+    QIODevice* _device{nullptr};
+    qint64 _size{0};
+    bool _sequential{false};
+    QString _errorString;
+    std::vector<Slot> _slots;
+    size_t _readIndex{0};
+    size_t _writeIndex{0};
+    size_t _filled{0};
+    bool _holding{false};
+    bool _stopping{false};
+    qint64 _position{0};
+
+    QThreadPool _pool;
+    mutable QMutex _mutex;
+    QWaitCondition _dataAvailable;
+    QWaitCondition _spaceAvailable;
+};
+} // namespace QtLibArchive
+
+#endif
@@ -4,11 +4,52 @@
 #include <QtLibArchive/Reader.h>
 #include <QtLibArchive/ReaderIterator.h>
 
+#include "Extractor_p.h"
+#include "FunctionRunnable_p.h"
+#include "ReaderIterator_p.h"
+#include "StatisticsCollector_p.h"
+
 #include <archive.h>
 
 #include <QDir>
+#include <QSet>
+#include <QThreadPool>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
 
 namespace QtLibArchive {
+namespace {
+/*!
+ * Chains of hard links are followed this far, which also stops links referring to each other
+ * in a corrupt archive.
+ */
+constexpr int MaxLinkDepth = 8;
+
+/*!
+ * Returns the cleaned target if \a entry is a hard link without data of its own, e.g. written
+ * by deduplication, whose data is that of the earlier entry it refers to.
+ */
+std::optional<QString> linkTarget(const ReaderEntry& entry)
+{
+    std::optional<QString> hardlink = entry.hardlink();
+
+    if (!hardlink || entry.size().value_or(0) != 0) {
+        return std::nullopt;
+    }
+
+    QString target = QDir::cleanPath(*hardlink);
+    if (target == entry.cleanPathName()) {
+        return std::nullopt;
+    }
+
+    return target;
+}
+} // namespace
+
 Reader::Reader(
     QString fileName,
     QList<SupportedFormat> supportedFormats,
@@ -17,7 +58,7 @@ Reader::Reader(
     , _supportedFormats{std::move(supportedFormats)}
     , _supportedFilters{std::move(supportedFilters)}
 {
-    _error = iterator().error();
+    probe();
 }
 
 Reader::Reader(SupportedFormat supportedFormat, SupportedFilter supportedFilter)
@@ -25,8 +66,50 @@ Reader::Reader(SupportedFormat supportedFormat, SupportedFilter supportedFilter)
     , _supportedFilters{supportedFilter}
 {}
 
+Reader::Reader(
+    Source source,
+    QByteArray data,
+    QIODevice* device,
+    QList<SupportedFormat> supportedFormats,
+    QList<SupportedFilter> supportedFilters)
+    : _source{source}
+    , _data{std::move(data)}
+    , _device{device}
+    , _deviceInUse{device != nullptr ? std::make_shared<std::atomic<bool>>(false) : nullptr}
+    , _supportedFormats{std::move(supportedFormats)}
+    , _supportedFilters{std::move(supportedFilters)}
+{
+    probe();
+}
+
 Reader::~Reader() {}
 
+Reader Reader::fromData(
+    QByteArray data,
+    QList<SupportedFormat> supportedFormats,
+    QList<SupportedFilter> supportedFilters)
+{
+    return Reader{
+        Source::Memory,
+        std::move(data),
+        nullptr,
+        std::move(supportedFormats),
+        std::move(supportedFilters)};
+}
+
+Reader Reader::fromDevice(
+    QIODevice* device,
+    QList<SupportedFormat> supportedFormats,
+    QList<SupportedFilter> supportedFilters)
+{
+    return Reader{
+        Source::Device,
+        QByteArray{},
+        device,
+        std::move(supportedFormats),
+        std::move(supportedFilters)};
+}
+
 QString Reader::fileName() const
 {
     return _fileName;
@@ -49,44 +132,620 @@ ReaderError Reader::error() const
 
 qint64 Reader::fileCount()
 {
-    if (!_fileCount.has_value()) {
-        qint64 count = 0;
-        auto it = iterator();
-        while (it.next()) {
-            count++;
-        }
-        _fileCount = count;
+    if (!_fileCount.has_value() && !buildIndex()) {
+        _fileCount = 0;
+        _fileCountExact = false;
     }
 
     return _fileCount.value();
 }
 
+bool Reader::isFileCountExact() const
+{
+    return _fileCount.has_value() && _fileCountExact;
+}
+
 bool Reader::open(const QString& fileName, qint64 blockSize)
 {
+    reset(Source::File);
     _fileName = fileName;
     _blockSize = blockSize;
-    _error = iterator().error();
+    probe();
 
     return _error == ReaderError::None;
 }
 
+bool Reader::openMapped(const QString& fileName)
+{
+    auto file = std::make_shared<QFile>(fileName);
+    uchar* data = nullptr;
+
+    if (file->open(QIODevice::ReadOnly) && file->size() > 0) {
+        data = file->map(0, file->size());
+    }
+
+    if (data == nullptr) {
+        return open(fileName, _blockSize);
+    }
+
+#ifdef Q_OS_UNIX
+    // The mapping starts at offset 0 and is therefore page-aligned. The hints are best effort.
+    madvise(data, static_cast<size_t>(file->size()), MADV_SEQUENTIAL);
+    madvise(data, static_cast<size_t>(file->size()), MADV_WILLNEED);
+#endif
+
+    reset(Source::Mapped);
+    _fileName = fileName;
+    _mappedData = data;
+    _mappedSize = file->size();
+    _mappedFile = std::move(file);
+    probe();
+
+    return _error == ReaderError::None;
+}
+
+bool Reader::isMapped() const
+{
+    return _source == Source::Mapped;
+}
+
+void Reader::probe()
+{
+    // Keep the handle for the first iterator instead of opening the archive twice. Opening it
+    // locks the mutex itself.
+    auto handle = std::make_unique<ReaderIteratorPrivate>(this, _blockSize);
+    _error = handle->_error;
+
+    if (_error == ReaderError::None) {
+        QMutexLocker locker{&_probe.mutex};
+        _probe.handle = std::move(handle);
+    }
+}
+
+void Reader::reset(Source source)
+{
+    _probe.handle.reset();
+    _probe.detected = std::make_shared<DetectedFormat>();
+    _source = source;
+    _data.clear();
+    _device = nullptr;
+    _deviceInUse.reset();
+    _mappedFile.reset();
+    _mappedData = nullptr;
+    _mappedSize = 0;
+    _fileCount = std::nullopt;
+    _fileCountExact = false;
+    _index = std::nullopt;
+}
+
+void Reader::setReadAhead(int blocks)
+{
+    _readAheadBlocks = qMax(blocks, 0);
+
+    // The cached handle reads the file directly.
+    if (_source == Source::File) {
+        _probe.handle.reset();
+    }
+}
+
+int Reader::readAhead() const
+{
+    return _readAheadBlocks;
+}
+
+void Reader::setStatisticsEnabled(bool enabled)
+{
+    if (enabled == isStatisticsEnabled()) {
+        return;
+    }
+
+    _statistics = enabled ? std::make_shared<StatisticsAccumulator>() : nullptr;
+
+    QMutexLocker locker{&_probe.mutex};
+
+    if (!_probe.handle) {
+        return;
+    }
+
+    // A sequential device cannot be read a second time, so its cached handle keeps being used
+    // and counts from now on. Other sources simply reopen the archive with statistics.
+    if (_source == Source::Device && _device != nullptr && _device->isSequential()) {
+        _probe.handle->setStatistics(_statistics, _statisticsCallback);
+    } else {
+        _probe.handle.reset();
+    }
+}
+
+bool Reader::isStatisticsEnabled() const
+{
+    return _statistics != nullptr;
+}
+
+Statistics Reader::statistics() const
+{
+    return _statistics ? _statistics->total() : Statistics{};
+}
+
+void Reader::setStatisticsCallback(StatisticsCallback callback)
+{
+    _statisticsCallback = std::move(callback);
+
+    QMutexLocker locker{&_probe.mutex};
+
+    if (_probe.handle && _probe.handle->_statistics) {
+        _probe.handle->_statisticsCallback = _statisticsCallback;
+    }
+}
+
 ReaderIterator Reader::iterator() const
 {
+    std::unique_ptr<ReaderIteratorPrivate> handle;
+
+    {
+        QMutexLocker locker{&_probe.mutex};
+        handle = std::move(_probe.handle);
+    }
+
+    if (handle) {
+        return ReaderIterator{std::move(handle)};
+    }
+
     return ReaderIterator{this, _blockSize};
 }
 
+ReaderListing Reader::list() const
+{
+    ReaderListing listing;
+    ReaderIterator it{iterator()};
+
+    // The records are filled from the raw header, so no ReaderEntry accessor runs per entry.
+    while (it.next()) {
+        listing.append(it.d_ptr->_archiveEntry);
+    }
+
+    listing._complete = it.error() == ReaderError::None;
+    listing.squeeze();
+
+    return listing;
+}
+
 std::optional<QByteArray> Reader::fileData(const QString& pathName) const
 {
     QString cleanPathName = QDir::cleanPath(pathName);
 
+    if (_index) {
+        auto found = _index->constFind(cleanPathName);
+        if (found == _index->constEnd()) {
+            return std::nullopt;
+        }
+
+        if (std::optional<QByteArray> data = indexedFileData(*found)) {
+            return data;
+        }
+
+        // The archive changed since the index was built. Fall back to scanning it.
+    }
+
+    QHash<QString, QByteArray> data = filesData(QStringList{cleanPathName});
+
+    auto found = data.constFind(cleanPathName);
+    if (found == data.constEnd()) {
+        return std::nullopt;
+    }
+
+    return *found;
+}
+
+QHash<QString, QByteArray> Reader::filesData(const QStringList& pathNames) const
+{
+    QHash<QString, QByteArray> result;
+
+    // Paths still to be read, each with the requested paths waiting for its data. Hard links
+    // wait for their target, which precedes them in the archive; a target read in the same
+    // pass resolves them at once, others are read in a further pass.
+    QHash<QString, QStringList> waiting;
+    for (const QString& pathName : pathNames) {
+        QString cleanPathName = QDir::cleanPath(pathName);
+        waiting[cleanPathName] = QStringList{cleanPathName};
+    }
+
+    for (int pass = 0; pass <= MaxLinkDepth && !waiting.isEmpty(); ++pass) {
+        QHash<QString, QStringList> linked;
+
+        filesData(waiting.keys(), [&](const QString& pathName, ReaderIterator& iterator) {
+            const QStringList requested = waiting.value(pathName);
+            std::optional<QString> target = linkTarget(iterator.entry());
+
+            if (!target) {
+                QByteArray data = iterator.readData();
+                for (const QString& requestedPath : requested) {
+                    result.insert(requestedPath, data);
+                }
+            } else if (result.contains(*target)) {
+                QByteArray data = result.value(*target);
+                for (const QString& requestedPath : requested) {
+                    result.insert(requestedPath, data);
+                }
+            } else {
+                linked[*target] += requested;
+            }
+        });
+
+        waiting = std::move(linked);
+    }
+
+    return result;
+}
+
+bool Reader::filesData(
+    const QStringList& pathNames,
+    const std::function<void(const QString& pathName, ReaderIterator& iterator)>& callback) const
+{
+    QSet<QString> wanted;
+    for (const QString& pathName : pathNames) {
+        wanted.insert(QDir::cleanPath(pathName));
+    }
+
+    bool allFound = true;
+
+    if (_index) {
+        // Without the paths the archive does not contain, the scan can stop at the last match.
+        for (auto it = wanted.begin(); it != wanted.end();) {
+            if (_index->contains(*it)) {
+                ++it;
+            } else {
+                it = wanted.erase(it);
+                allFound = false;
+            }
+        }
+    }
+
     ReaderIterator it{iterator()};
 
+    while (!wanted.isEmpty() && it.next()) {
+        std::optional<QString> cleanPathName = it.entry().cleanPathName();
+
+        if (cleanPathName && wanted.remove(*cleanPathName)) {
+            callback(*cleanPathName, it);
+        }
+    }
+
+    return allFound && wanted.isEmpty();
+}
+
+bool Reader::extractParallel(
+    const QStringList& pathNames,
+    const std::function<bool(const ReaderIndexEntry& entry, ReaderIterator& iterator)>& sink,
+    int threads)
+{
+    std::atomic<bool> cancelled{false};
+
+    // Indexing would consume a sequential device, so stream it in a single pass instead.
+    if (_source == Source::Device && _device != nullptr && _device->isSequential()) {
+        QSet<QString> wanted;
+        for (const QString& pathName : pathNames) {
+            wanted.insert(QDir::cleanPath(pathName));
+        }
+
+        ReaderIterator it{iterator()};
+        qint64 count = 0;
+
+        while ((pathNames.isEmpty() || !wanted.isEmpty()) && it.next()) {
+            std::optional<ReaderIndexEntry> entry = makeIndexEntry(it, count++);
+
+            if (!entry || (!pathNames.isEmpty() && !wanted.remove(entry->pathName))) {
+                continue;
+            }
+
+            if (!sink(*entry, it)) {
+                return false;
+            }
+        }
+
+        return wanted.isEmpty() && it.error() == ReaderError::None;
+    }
+
+    if (!_index && !buildIndex()) {
+        return false;
+    }
+
+    QList<ReaderIndexEntry> entries;
+    bool allFound = true;
+
+    if (pathNames.isEmpty()) {
+        entries = _index->values();
+        std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.index < rhs.index;
+        });
+    } else {
+        entries = indexEntries(pathNames);
+
+        for (const QString& pathName : pathNames) {
+            allFound = allFound && _index->contains(QDir::cleanPath(pathName));
+        }
+    }
+
+    if (threads <= 1 || entries.size() < 2 || !supportsParallelExtraction()) {
+        ReaderIterator it{iterator()};
+        return extractRange(it, -1, entries, sink, cancelled) && allFound;
+    }
+
+    // Balance the ranges by size rather than by count, so that a few large entries do not end
+    // up on the same worker. Every entry is charged a header on top of its data.
+    constexpr qint64 HeaderCost = 512;
+    qint64 totalSize = 0;
+    for (const ReaderIndexEntry& entry : entries) {
+        totalSize += entry.size.value_or(0) + HeaderCost;
+    }
+
+    const qint64 rangeTarget = totalSize / threads + 1;
+    QList<QList<ReaderIndexEntry>> ranges{{}};
+    qint64 rangeSize = 0;
+
+    for (const ReaderIndexEntry& entry : entries) {
+        if (rangeSize >= rangeTarget && ranges.size() < threads) {
+            ranges.push_back({});
+            rangeSize = 0;
+        }
+
+        ranges.last().push_back(entry);
+        rangeSize += entry.size.value_or(0) + HeaderCost;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(ranges.size());
+
+    for (const QList<ReaderIndexEntry>& range : ranges) {
+        pool.start(new FunctionRunnable{[this, range, &sink, &cancelled]() {
+            // Uncompressed tar and cpio archives can be opened right at the first header.
+            const ReaderIndexEntry& first = range.first();
+            qint64 startOffset = _indexSeekable ? first.headerOffset : 0;
+
+            ReaderIterator it{this, _blockSize, startOffset, _indexFormat};
+            qint64 position = startOffset > 0 ? first.index - 1 : -1;
+
+            if (!extractRange(it, position, range, sink, cancelled)) {
+                cancelled = true;
+            }
+        }});
+    }
+
+    pool.waitForDone();
+
+    return !cancelled && allFound;
+}
+
+bool Reader::extractTo(const QString& directory, const ExtractOptions& options) const
+{
+    Extractor extractor{directory, options};
+    ReaderIterator it{iterator()};
+    bool ok = it.error() == ReaderError::None;
+
+    while (ok && it.next()) {
+        ok = extractor.extract(it);
+    }
+
+    // The I/O threads are waited for even if extraction stopped early.
+    return extractor.finish() && ok && it.error() == ReaderError::None;
+}
+
+bool Reader::buildIndex()
+{
+    ReaderIterator it{iterator()};
+
+    if (it.error() != ReaderError::None) {
+        _error = it.error();
+        return false;
+    }
+
+    QHash<QString, ReaderIndexEntry> index;
+    qint64 count = 0;
+
     while (it.next()) {
-        if (it.entry().cleanPathName() == cleanPathName) {
-            return it.readData();
+        std::optional<ReaderIndexEntry> indexEntry = makeIndexEntry(it, count++);
+        if (!indexEntry) {
+            continue;
+        }
+
+        // Like the linear search in fileData(), the first entry wins if a path occurs twice.
+        if (!index.contains(indexEntry->pathName)) {
+            index.insert(indexEntry->pathName, *indexEntry);
         }
     }
 
+    // A sequential device cannot be rewound to a header offset.
+    bool sequential = _source == Source::Device && _device->isSequential();
+    _indexSeekable = it.isSeekable() && !sequential;
+    _indexFormat = it.formatCode();
+    _fileCount = count;
+    _fileCountExact = it.error() == ReaderError::None;
+    _index = std::move(index);
+
+    return true;
+}
+
+bool Reader::hasIndex() const
+{
+    return _index.has_value();
+}
+
+std::optional<ReaderIndexEntry> Reader::indexEntry(const QString& pathName)
+{
+    if (!_index && !buildIndex()) {
+        return std::nullopt;
+    }
+
+    auto found = _index->constFind(QDir::cleanPath(pathName));
+    return found != _index->constEnd() ? std::make_optional(*found) : std::nullopt;
+}
+
+QList<ReaderIndexEntry> Reader::indexEntries(const QStringList& pathNames)
+{
+    QList<ReaderIndexEntry> entries;
+
+    if (!_index && !buildIndex()) {
+        return entries;
+    }
+
+    QSet<qint64> seen;
+
+    for (const QString& pathName : pathNames) {
+        auto found = _index->constFind(QDir::cleanPath(pathName));
+
+        if (found != _index->constEnd() && !seen.contains(found->index)) {
+            seen.insert(found->index);
+            entries.push_back(*found);
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.index < rhs.index;
+    });
+
+    return entries;
+}
+
+std::optional<ReaderIndexEntry> Reader::makeIndexEntry(const ReaderIterator& it, qint64 index)
+{
+    ReaderEntry entry = it.entry();
+
+    std::optional<QString> cleanPathName = entry.cleanPathName();
+    if (!cleanPathName) {
+        return std::nullopt;
+    }
+
+    ReaderIndexEntry indexEntry;
+    indexEntry.pathName = *cleanPathName;
+    indexEntry.index = index;
+    indexEntry.headerOffset = it.headerPosition();
+    indexEntry.fileType = entry.fileType();
+    indexEntry.size = entry.size();
+    indexEntry.permissions = entry.permissions();
+    indexEntry.mtime = entry.mtime();
+
+    return indexEntry;
+}
+
+bool Reader::supportsParallelExtraction() const
+{
+    // The workers' handles would all move the position of the same device.
+    if (_source == Source::Device) {
+        return false;
+    }
+
+    if (_indexSeekable) {
+        return true;
+    }
+
+    // Zip members are compressed independently, but only a seekable, uncompressed input lets
+    // the workers skip to their members without decompressing everything before. 7z archives
+    // are usually solid, i.e. compressed as one stream, so they are not split up.
+    int format = _indexFormat & ARCHIVE_FORMAT_BASE_MASK;
+    QMutexLocker locker{&_probe.detected->mutex};
+    return _probe.detected->filters.isEmpty() && format == ARCHIVE_FORMAT_ZIP;
+}
+
+bool Reader::extractRange(
+    ReaderIterator& it,
+    qint64 position,
+    const QList<ReaderIndexEntry>& entries,
+    const std::function<bool(const ReaderIndexEntry& entry, ReaderIterator& iterator)>& sink,
+    const std::atomic<bool>& cancelled) const
+{
+    for (const ReaderIndexEntry& entry : entries) {
+        while (position < entry.index) {
+            if (cancelled || !it.next()) {
+                return false;
+            }
+
+            position++;
+        }
+
+        // The archive changed since the index was built.
+        if (it.entry().cleanPathName() != entry.pathName) {
+            return false;
+        }
+
+        if (!sink(entry, it)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::optional<QByteArray> Reader::indexedFileData(const ReaderIndexEntry& entry) const
+{
+    const ReaderIndexEntry* current = &entry;
+
+    // Hard links are followed through the index to the entry holding the data.
+    for (int depth = 0; depth <= MaxLinkDepth; ++depth) {
+        std::optional<ReaderIterator> it = indexedIterator(*current);
+        if (!it) {
+            return std::nullopt;
+        }
+
+        std::optional<QString> target = linkTarget(it->entry());
+        if (!target) {
+            return it->readData();
+        }
+
+        auto found = _index->constFind(*target);
+        if (found == _index->constEnd()) {
+            return std::nullopt;
+        }
+
+        current = &*found;
+    }
+
     return std::nullopt;
 }
+
+std::optional<ReaderIterator> Reader::indexedIterator(const ReaderIndexEntry& entry) const
+{
+    if (_indexSeekable && entry.headerOffset > 0) {
+        ReaderIterator it{this, _blockSize, entry.headerOffset, _indexFormat};
+
+        if (it.next() && it.entry().cleanPathName() == entry.pathName) {
+            return std::move(it);
+        }
+
+        return std::nullopt;
+    }
+
+    // Skipping headers by position avoids converting and comparing every path name.
+    ReaderIterator it{iterator()};
+
+    for (qint64 i = 0; i <= entry.index; ++i) {
+        if (!it.next()) {
+            return std::nullopt;
+        }
+    }
+
+    if (it.entry().cleanPathName() != entry.pathName) {
+        return std::nullopt;
+    }
+
+    return std::move(it);
+}
+
+Reader::ProbeCache::ProbeCache()
+    : detected{std::make_shared<DetectedFormat>()}
+{}
+
+Reader::ProbeCache::ProbeCache(const ProbeCache& other)
+    : detected{other.detected}
+{}
+
+Reader::ProbeCache::~ProbeCache() = default;
+
+Reader::ProbeCache& Reader::ProbeCache::operator=(const ProbeCache& rhs)
+{
+    if (this != &rhs) {
+        detected = rhs.detected;
+        handle.reset();
+    }
+
+    return *this;
+}
 } // namespace QtLibArchive
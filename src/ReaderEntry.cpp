@@ -3,6 +3,9 @@
 
 #include <QtLibArchive/ReaderEntry.h>
 
+#include "DigestCalculator_p.h"
+#include "Permissions_p.h"
+
 #include <QDir>
 
 #include <archive.h>
@@ -45,6 +48,78 @@ std::optional<QString> ReaderEntry::pathName() const
     return std::nullopt;
 }
 
+QList<SparseRegion> ReaderEntry::sparseRegions() const
+{
+    Q_ASSERT(_entry != nullptr);
+
+    QList<SparseRegion> regions;
+    la_int64_t offset = 0;
+    la_int64_t length = 0;
+
+    if (archive_entry_sparse_reset(_entry) == 0) {
+        return regions;
+    }
+
+    while (archive_entry_sparse_next(_entry, &offset, &length) == ARCHIVE_OK) {
+        regions.push_back({offset, length});
+    }
+
+    return regions;
+}
+
+std::optional<QString> ReaderEntry::hardlink() const
+{
+    Q_ASSERT(_entry != nullptr);
+    const char* target = archive_entry_hardlink_utf8(_entry);
+    if (target != nullptr) {
+        return QString::fromUtf8(target);
+    }
+
+    return std::nullopt;
+}
+
+std::optional<QString> ReaderEntry::symlink() const
+{
+    Q_ASSERT(_entry != nullptr);
+    const char* target = archive_entry_symlink_utf8(_entry);
+    if (target != nullptr) {
+        return QString::fromUtf8(target);
+    }
+
+    return std::nullopt;
+}
+
+Digests ReaderEntry::storedDigests() const
+{
+    Q_ASSERT(_entry != nullptr);
+
+    Digests digests;
+
+    if (archive_entry_xattr_reset(_entry) == 0) {
+        return digests;
+    }
+
+    const char* name = nullptr;
+    const void* value = nullptr;
+    size_t size = 0;
+
+    while (archive_entry_xattr_next(_entry, &name, &value, &size) == ARCHIVE_OK) {
+        for (DigestAlgorithm algorithm :
+             {DigestAlgorithm::Crc32,
+              DigestAlgorithm::Md5,
+              DigestAlgorithm::Sha1,
+              DigestAlgorithm::Sha256,
+              DigestAlgorithm::Sha512}) {
+            if (qstrcmp(name, DigestCalculator::attributeName(algorithm)) == 0) {
+                digests.insert(
+                    algorithm, QByteArray{static_cast<const char*>(value), static_cast<int>(size)});
+            }
+        }
+    }
+
+    return digests;
+}
+
 std::optional<qint64> ReaderEntry::size() const
 {
     Q_ASSERT(_entry != nullptr);
@@ -92,27 +167,6 @@ std::optional<QFileDevice::Permissions> ReaderEntry::permissions() const
         return std::nullopt;
     }
 
-    QFile::Permissions permissions{};
-
-    auto mode = archive_entry_perm(_entry);
-
-    static const QList<QPair<int, QFileDevice::Permission>> Mapping{
-        {S_IRUSR, QFileDevice::ReadOwner},
-        {S_IWUSR, QFileDevice::WriteOwner},
-        {S_IXUSR, QFileDevice::ExeOwner},
-        {S_IRGRP, QFileDevice::ReadGroup},
-        {S_IWGRP, QFileDevice::WriteGroup},
-        {S_IXGRP, QFileDevice::ExeGroup},
-        {S_IROTH, QFileDevice::ReadOther},
-        {S_IWOTH, QFileDevice::WriteOther},
-        {S_IXOTH, QFileDevice::ExeOther}};
-
-    for (auto [mask, permission] : Mapping) {
-        if (mode & mask) {
-            permissions |= permission;
-        }
-    }
-
-    return permissions;
+    return permissionsFromMode(archive_entry_perm(_entry));
 }
 } // namespace QtLibArchive
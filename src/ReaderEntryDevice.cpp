@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include <QtLibArchive/ReaderEntryDevice.h>
+#include <QtLibArchive/ReaderIterator.h>
+
+namespace QtLibArchive {
+ReaderEntryDevice::ReaderEntryDevice(ReaderIterator* iterator, QObject* parent)
+    : QIODevice{parent}
+    , _iterator{iterator}
+{
+    Q_ASSERT(iterator != nullptr);
+}
+
+ReaderEntryDevice::~ReaderEntryDevice() {}
+
+bool ReaderEntryDevice::open(OpenMode mode)
+{
+    if ((mode & QIODevice::ReadWrite) != QIODevice::ReadOnly) {
+        setErrorString(QStringLiteral("Archive entries can only be opened for reading"));
+        return false;
+    }
+
+    if (!_iterator->isValid()) {
+        setErrorString(QStringLiteral("The iterator is not positioned on an entry"));
+        return false;
+    }
+
+    _entrySize = _iterator->entry().size();
+    _consumed = 0;
+    _finished = false;
+
+    return QIODevice::open(mode);
+}
+
+void ReaderEntryDevice::close()
+{
+    QIODevice::close();
+
+    _entrySize = std::nullopt;
+    _consumed = 0;
+    _finished = false;
+}
+
+bool ReaderEntryDevice::isSequential() const
+{
+    return true;
+}
+
+bool ReaderEntryDevice::atEnd() const
+{
+    if (!isOpen()) {
+        return true;
+    }
+
+    if (_entrySize) {
+        return _consumed >= *_entrySize && QIODevice::bytesAvailable() == 0;
+    }
+
+    return _finished && QIODevice::bytesAvailable() == 0;
+}
+
+qint64 ReaderEntryDevice::size() const
+{
+    return _entrySize.value_or(0);
+}
+
+qint64 ReaderEntryDevice::bytesAvailable() const
+{
+    qint64 remaining = _entrySize ? qMax<qint64>(*_entrySize - _consumed, 0) : 0;
+    return QIODevice::bytesAvailable() + remaining;
+}
+
+qint64 ReaderEntryDevice::readData(char* data, qint64 maxSize)
+{
+    if (_finished) {
+        return -1;
+    }
+
+    qint64 read = _iterator->readChunk(data, maxSize);
+
+    if (read < 0) {
+        setErrorString(QStringLiteral("Cannot read archive entry data"));
+        _finished = true;
+        return -1;
+    }
+
+    if (read == 0 && maxSize > 0) {
+        _finished = true;
+        return -1;
+    }
+
+    _consumed += read;
+    return read;
+}
+
+qint64 ReaderEntryDevice::writeData(const char*, qint64)
+{
+    return -1;
+}
+} // namespace QtLibArchive
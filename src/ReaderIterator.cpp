@@ -4,70 +4,479 @@
 #include <QtLibArchive/Reader.h>
 #include <QtLibArchive/ReaderIterator.h>
 
+#include "ReaderIterator_p.h"
+
 #include <archive.h>
 #include <archive_entry.h>
 
 #include <QDir>
+#include <QFile>
+
+#include <cstdio>
 
 #include "archive_entry.h"
 
 namespace QtLibArchive {
-class ReaderIteratorPrivate
+namespace {
+/*!
+ * Calls archive_read_data until \a size bytes were read or the entry ends.
+ *
+ * A single call may return less than requested even in the middle of an entry. An error
+ * returns -1 even if some data was read before, so it is not mistaken for the end of the entry.
+ */
+qint64 readFully(archive* handle, char* data, qint64 size)
 {
-    friend class ReaderIterator;
+    qint64 total = 0;
 
-public:
-    ReaderIteratorPrivate(const Reader* reader, qint64 blockSize)
-        : _reader{reader}
-        , _blockSize{blockSize}
-        , _archive{archive_read_new()}
-    {
-        Q_ASSERT(reader != nullptr);
+    while (total < size) {
+        la_ssize_t read = archive_read_data(handle, data + total, size - total);
+
+        if (read < 0) {
+            return -1;
+        }
+
+        if (read == 0) {
+            break;
+        }
+
+        total += read;
+    }
 
-        if (_archive == nullptr) {
-            _error = ReaderError::CannotAllocateMemory;
+    return total;
+}
+} // namespace
+
+ReaderIteratorPrivate::ReaderIteratorPrivate(
+    const Reader* reader, qint64 blockSize, qint64 startOffset, int formatCode)
+    : _blockSize{blockSize}
+    , _archive{archive_read_new()}
+    , _detectedFormat{reader->_probe.detected}
+{
+    Q_ASSERT(reader != nullptr);
+
+    setStatistics(reader->_statistics, reader->_statisticsCallback);
+
+    // Opening reads the first blocks and probes the format and filters.
+    StatisticsCollector::Timer timer{_statistics.get(), StatisticsCollector::Stage::Codec};
+
+    if (_archive == nullptr) {
+        _error = ReaderError::CannotAllocateMemory;
+        return;
+    }
+
+    if (startOffset > 0) {
+        // Reading starts at a header found by a previous pass. Its format is known and the
+        // data is not compressed, so there is nothing to probe.
+        if (archive_read_support_format_by_code(_archive, formatCode) != ARCHIVE_OK) {
+            _error = ReaderError::FormatNotSupported;
             return;
         }
 
-        if (reader->supportedFormats().contains(SupportedFormat::All)) {
-            archive_read_support_format_all(_archive);
-        } else {
-            for (SupportedFormat format : reader->supportedFormats()) {
-                if (archive_read_support_format_by_code(_archive, static_cast<int>(format))
-                    != ARCHIVE_OK) {
-                    _error = ReaderError::FormatNotSupported;
-                    break;
-                }
+        // The format is the one detected before, there is nothing new to record.
+        _formatRecorded = true;
+
+        if (!open(*reader, startOffset) && _error == ReaderError::None) {
+            _error = ReaderError::CannotOpenFile;
+        }
+
+        return;
+    }
+
+    // Registering every format and filter is a noticeable part of opening small archives.
+    // Once a previous handle detected what the archive uses, only that is registered.
+    if (!supportDetectedFormatAndFilters()) {
+        supportConfiguredFormatsAndFilters(*reader);
+    }
+
+    if (!open(*reader, 0) && _error == ReaderError::None) {
+        _error = ReaderError::CannotOpenFile;
+    }
+}
+
+ReaderIteratorPrivate::~ReaderIteratorPrivate()
+{
+    finishStatistics();
+
+    if (_archive != nullptr) {
+        archive_read_close(_archive);
+        archive_read_free(_archive);
+        _archive = nullptr;
+        releaseDevice();
+    }
+}
+
+void ReaderIteratorPrivate::supportConfiguredFormatsAndFilters(const Reader& reader)
+{
+    if (reader.supportedFormats().contains(SupportedFormat::All)) {
+        archive_read_support_format_all(_archive);
+    } else {
+        for (SupportedFormat format : reader.supportedFormats()) {
+            if (archive_read_support_format_by_code(_archive, static_cast<int>(format))
+                != ARCHIVE_OK) {
+                _error = ReaderError::FormatNotSupported;
+                break;
             }
         }
+    }
 
-        if (reader->supportedFilters().contains(SupportedFilter::All)) {
-            archive_read_support_filter_all(_archive);
-        } else {
-            for (SupportedFilter filter : reader->supportedFilters()) {
-                if (archive_read_support_filter_by_code(_archive, static_cast<int>(filter))
-                    != ARCHIVE_OK) {
-                    _error = ReaderError::FilterNotSupported;
-                    break;
-                }
+    if (reader.supportedFilters().contains(SupportedFilter::All)) {
+        archive_read_support_filter_all(_archive);
+    } else {
+        for (SupportedFilter filter : reader.supportedFilters()) {
+            if (archive_read_support_filter_by_code(_archive, static_cast<int>(filter))
+                != ARCHIVE_OK) {
+                _error = ReaderError::FilterNotSupported;
+                break;
             }
         }
+    }
+}
 
-        if (archive_read_open_filename_w(
-                _archive, reader->fileName().toStdWString().c_str(), _blockSize)
-            != ARCHIVE_OK) {
-            _error = ReaderError::CannotOpenFile;
+bool ReaderIteratorPrivate::supportDetectedFormatAndFilters()
+{
+    int format = 0;
+    QList<int> filters;
+
+    {
+        QMutexLocker locker{&_detectedFormat->mutex};
+        format = _detectedFormat->format;
+        filters = _detectedFormat->filters;
+    }
+
+    if (format == 0) {
+        return false;
+    }
+
+    if (archive_read_support_format_by_code(_archive, format) != ARCHIVE_OK) {
+        return false;
+    }
+
+    for (int filter : filters) {
+        if (archive_read_support_filter_by_code(_archive, filter) != ARCHIVE_OK) {
+            return false;
         }
     }
 
-private:
-    const Reader* _reader{nullptr};
-    qint64 _blockSize{10240};
-    archive* _archive{nullptr};
-    archive_entry* _archiveEntry{nullptr};
-    bool _isValid{false};
-    ReaderError _error{ReaderError::None};
-};
+    return true;
+}
+
+void ReaderIteratorPrivate::rememberDetectedFormatAndFilters()
+{
+    // The last filter in the chain reads the raw input and is not a decompressor.
+    QList<int> filters;
+    for (int i = 0; i < archive_filter_count(_archive) - 1; ++i) {
+        filters.push_back(archive_filter_code(_archive, i));
+    }
+
+    // Iterators on other threads may have got here first.
+    QMutexLocker locker{&_detectedFormat->mutex};
+
+    if (_detectedFormat->format != 0) {
+        return;
+    }
+
+    _detectedFormat->filters = filters;
+    _detectedFormat->format = archive_format(_archive);
+}
+
+bool ReaderIteratorPrivate::open(const Reader& reader, qint64 startOffset)
+{
+    switch (reader._source) {
+    case Reader::Source::File:
+        break;
+    case Reader::Source::Memory:
+        // Holding a reference keeps the buffer alive without copying it.
+        _data = reader._data;
+
+        if (startOffset > _data.size()) {
+            return false;
+        }
+
+        return archive_read_open_memory(
+                   _archive, _data.constData() + startOffset, _data.size() - startOffset)
+               == ARCHIVE_OK;
+    case Reader::Source::Mapped:
+        // The mapping lives as long as the file, which the reader may close on reopening.
+        _mappedFile = reader._mappedFile;
+
+        if (startOffset > reader._mappedSize) {
+            return false;
+        }
+
+        return archive_read_open_memory(
+                   _archive,
+                   reader._mappedData + startOffset,
+                   static_cast<size_t>(reader._mappedSize - startOffset))
+               == ARCHIVE_OK;
+    case Reader::Source::Device:
+        return claimDevice(reader) && openDevice(reader._device, startOffset);
+    }
+
+    // libarchive's own file handling cannot be timed, so statistics need the callbacks.
+    if (startOffset == 0 && reader._readAheadBlocks <= 0 && !_statistics) {
+        return archive_read_open_filename_w(
+                   _archive, reader.fileName().toStdWString().c_str(), _blockSize)
+               == ARCHIVE_OK;
+    }
+
+    _file.setFileName(reader.fileName());
+    return _file.open(QIODevice::ReadOnly)
+           && openDevice(&_file, startOffset, reader._readAheadBlocks);
+}
+
+bool ReaderIteratorPrivate::openDevice(
+    QIODevice* device, qint64 startOffset, int readAheadBlocks)
+{
+    if (device == nullptr) {
+        return false;
+    }
+
+    if (!device->isOpen() && !device->open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    if (device->isSequential() ? startOffset > 0 : !device->seek(startOffset)) {
+        return false;
+    }
+
+    _device = device;
+    _deviceOffset = startOffset;
+    _position = startOffset;
+
+    if (readAheadBlocks > 0) {
+        _readAhead = std::make_unique<ReadAheadBuffer>(device, _blockSize, readAheadBlocks);
+        _fixedBufferBytes = _blockSize * readAheadBlocks;
+    } else {
+        _buffer.resize(_blockSize);
+        _fixedBufferBytes = _buffer.size();
+    }
+
+    if (_statistics) {
+        _statistics->setFixedBufferBytes(_fixedBufferBytes);
+    }
+
+    archive_read_set_read_callback(_archive, readCallback);
+    archive_read_set_skip_callback(_archive, skipCallback);
+    archive_read_set_callback_data(_archive, this);
+
+    // Formats like zip prefer seeking to the central directory, which needs random access.
+    if (!device->isSequential()) {
+        archive_read_set_seek_callback(_archive, seekCallback);
+    }
+
+    return archive_read_open1(_archive) == ARCHIVE_OK;
+}
+
+/*!
+ * Sequential devices cannot be rewound for another handle, so only one handle may read them at
+ * a time. Random-access devices are shared, see readCallback().
+ */
+bool ReaderIteratorPrivate::claimDevice(const Reader& reader)
+{
+    QIODevice* device = reader._device;
+
+    if (device == nullptr || !device->isSequential()) {
+        return true;
+    }
+
+    if (reader._deviceInUse->exchange(true)) {
+        _error = ReaderError::DeviceInUse;
+        return false;
+    }
+
+    _deviceInUse = reader._deviceInUse;
+    return true;
+}
+
+void ReaderIteratorPrivate::releaseDevice()
+{
+    if (_deviceInUse) {
+        *_deviceInUse = false;
+        _deviceInUse.reset();
+    }
+}
+
+la_ssize_t ReaderIteratorPrivate::readCallback(
+    archive* handle, void* clientData, const void** buffer)
+{
+    auto* d = static_cast<ReaderIteratorPrivate*>(clientData);
+    StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+
+    if (d->_readAhead) {
+        const char* data = nullptr;
+        qint64 read = d->_readAhead->read(&data);
+
+        if (read < 0) {
+            archive_set_error(
+                handle, ARCHIVE_ERRNO_MISC, "%s", qPrintable(d->_readAhead->errorString()));
+            return ARCHIVE_FATAL;
+        }
+
+        *buffer = data;
+        return read;
+    }
+
+    // Other handles of the reader may have moved the device, e.g. fileData() called while
+    // iterating, so every handle reads from its own position.
+    if (!d->_device->isSequential() && d->_device->pos() != d->_position
+        && !d->_device->seek(d->_position)) {
+        archive_set_error(
+            handle, ARCHIVE_ERRNO_MISC, "%s", qPrintable(d->_device->errorString()));
+        return ARCHIVE_FATAL;
+    }
+
+    qint64 read = d->_device->read(d->_buffer.data(), d->_buffer.size());
+    if (read < 0) {
+        archive_set_error(
+            handle, ARCHIVE_ERRNO_MISC, "%s", qPrintable(d->_device->errorString()));
+        return ARCHIVE_FATAL;
+    }
+
+    d->_position += read;
+    *buffer = d->_buffer.constData();
+    return read;
+}
+
+la_int64_t ReaderIteratorPrivate::skipCallback(archive*, void* clientData, la_int64_t request)
+{
+    auto* d = static_cast<ReaderIteratorPrivate*>(clientData);
+    StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+
+    // Returning 0 makes libarchive fall back to reading and discarding the data.
+    if (d->isSequential()) {
+        return 0;
+    }
+
+    qint64 position = d->position();
+    qint64 target = qMin(position + request, d->deviceSize());
+
+    if (!d->seek(target)) {
+        return 0;
+    }
+
+    return target - position;
+}
+
+la_int64_t ReaderIteratorPrivate::seekCallback(
+    archive*, void* clientData, la_int64_t offset, int whence)
+{
+    auto* d = static_cast<ReaderIteratorPrivate*>(clientData);
+    StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+
+    // Positions reported to libarchive are relative to the start of the archive data.
+    qint64 base = 0;
+    switch (whence) {
+    case SEEK_SET:
+        base = d->_deviceOffset;
+        break;
+    case SEEK_CUR:
+        base = d->position();
+        break;
+    case SEEK_END:
+        base = d->deviceSize();
+        break;
+    default:
+        return ARCHIVE_FATAL;
+    }
+
+    if (!d->seek(base + offset)) {
+        return ARCHIVE_FATAL;
+    }
+
+    return d->position() - d->_deviceOffset;
+}
+
+void ReaderIteratorPrivate::addToDigests(const char* data, qint64 size, qint64 offset) const
+{
+    if (_digests.isEmpty() || size <= 0) {
+        return;
+    }
+
+    // Holes skipped by readBlock() count as zeros, like readData() returns them.
+    if (offset > _digestOffset) {
+        _digests.addZeros(offset - _digestOffset);
+    }
+
+    _digests.addData(data, size);
+    _digestOffset = offset + size;
+}
+
+qint64 ReaderIteratorPrivate::position() const
+{
+    // Blocks read ahead are not consumed yet, so the device is further ahead than libarchive.
+    return _readAhead ? _readAhead->pos() : _position;
+}
+
+bool ReaderIteratorPrivate::seek(qint64 position)
+{
+    if (_readAhead) {
+        return _readAhead->seek(position);
+    }
+
+    if (!_device->seek(position)) {
+        return false;
+    }
+
+    _position = position;
+    return true;
+}
+
+qint64 ReaderIteratorPrivate::deviceSize() const
+{
+    // The device is read on the read-ahead thread meanwhile, so it must not be asked.
+    return _readAhead ? _readAhead->size() : _device->size();
+}
+
+bool ReaderIteratorPrivate::isSequential() const
+{
+    return _readAhead ? _readAhead->isSequential() : _device->isSequential();
+}
+
+void ReaderIteratorPrivate::countSkippedEntry()
+{
+    if (_statistics && _isValid && !_entryDataRead && archive_entry_size(_archiveEntry) > 0) {
+        _statistics->addSkippedEntry();
+    }
+}
+
+void ReaderIteratorPrivate::setStatistics(
+    std::shared_ptr<StatisticsAccumulator> total, StatisticsCallback callback)
+{
+    if (!total) {
+        _statistics.reset();
+        _statisticsTotal.reset();
+        _statisticsCallback = nullptr;
+        return;
+    }
+
+    _statistics = std::make_unique<StatisticsCollector>();
+    _statistics->setFixedBufferBytes(_fixedBufferBytes);
+    _statisticsTotal = std::move(total);
+    _statisticsCallback = std::move(callback);
+}
+
+void ReaderIteratorPrivate::finishStatistics()
+{
+    if (!_statistics || _finalStatistics) {
+        return;
+    }
+
+    countSkippedEntry();
+
+    if (_archive != nullptr) {
+        _statistics->updateFilters(_archive);
+    }
+
+    _finalStatistics = _statistics->statistics();
+
+    if (_statisticsTotal) {
+        _statisticsTotal->add(*_finalStatistics);
+    }
+
+    if (_statisticsCallback) {
+        _statisticsCallback(*_finalStatistics);
+    }
+}
 
 ReaderIterator::ReaderIterator(ReaderIterator&& other) noexcept
 {
@@ -93,7 +502,36 @@ std::optional<ReaderEntry> ReaderIterator::next()
 {
     Q_D(ReaderIterator);
 
-    d->_isValid = (archive_read_next_header(d->_archive, &d->_archiveEntry) == ARCHIVE_OK);
+    d->countSkippedEntry();
+
+    int r = ARCHIVE_OK;
+    {
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Codec};
+
+        // ARCHIVE_WARN still yields a usable header, e.g. one with an unknown pax keyword.
+        r = archive_read_next_header(d->_archive, &d->_archiveEntry);
+    }
+
+    d->_isValid = (r == ARCHIVE_OK || r == ARCHIVE_WARN);
+    d->_entryDataRead = false;
+
+    if (!d->_isValid && r != ARCHIVE_EOF && d->_error == ReaderError::None) {
+        d->_error = ReaderError::CannotReadData;
+    }
+
+    if (d->_isValid && d->_statistics) {
+        d->_statistics->addHeader();
+    }
+
+    // The format is known once the first header was read, and it does not change.
+    if (d->_isValid && !d->_formatRecorded) {
+        d->rememberDetectedFormatAndFilters();
+        d->_formatRecorded = true;
+    }
+
+    d->_digests.reset();
+    d->_digestOffset = 0;
+
     return d->_isValid ? std::make_optional(ReaderEntry{d->_archiveEntry}) : std::nullopt;
 }
 
@@ -101,11 +539,17 @@ void ReaderIterator::close()
 {
     Q_D(ReaderIterator);
 
-    if (d->_archive != nullptr) {
+    // A moved-from iterator has no private part.
+    if (d != nullptr && d->_archive != nullptr) {
+        d->finishStatistics();
+
+        // The read-ahead thread must not touch the device after it is handed back.
+        d->_readAhead.reset();
         archive_read_close(d->_archive);
         archive_read_free(d->_archive);
         d->_archive = nullptr;
         d->_isValid = false;
+        d->releaseDevice();
     }
 }
 
@@ -121,21 +565,166 @@ QByteArray ReaderIterator::readData(std::optional<qint64> maxSize) const
     Q_ASSERT(d->_isValid);
 
     QByteArray data;
+    d->_entryDataRead = true;
 
-    if (maxSize) {
-        data.resize(*maxSize);
-    } else {
-        auto expectedSize = entry().size();
+    std::optional<qint64> expectedSize = maxSize ? maxSize : entry().size();
 
-        if (expectedSize) {
-            data.resize(*expectedSize);
+    if (expectedSize) {
+        data.resize(*expectedSize);
+
+        if (d->_statistics) {
+            d->_statistics->addTransientBuffer(data.size());
+        }
+
+        qint64 read = 0;
+        {
+            StatisticsCollector::Timer timer{
+                d->_statistics.get(), StatisticsCollector::Stage::Codec};
+            read = readFully(d->_archive, data.data(), data.size());
+        }
+
+        if (read < 0) {
+            d->_error = ReaderError::CannotReadData;
         }
+
+        data.resize(qMax<qint64>(read, 0));
+        d->addToDigests(data.constData(), data.size(), d->_digestOffset);
+        return data;
     }
 
-    qint64 read = archive_read_data(d->_archive, data.data(), data.size());
-    data.resize(read);
+    // The size is not known in advance, e.g. for zip entries with a trailing data descriptor.
+    for (;;) {
+        qint64 offset = data.size();
+        data.resize(offset + d->_blockSize);
+
+        if (d->_statistics) {
+            d->_statistics->addTransientBuffer(data.size());
+        }
 
-    return data;
+        qint64 read = 0;
+        {
+            StatisticsCollector::Timer timer{
+                d->_statistics.get(), StatisticsCollector::Stage::Codec};
+            read = readFully(d->_archive, data.data() + offset, d->_blockSize);
+        }
+
+        if (read < 0) {
+            d->_error = ReaderError::CannotReadData;
+            return QByteArray{};
+        }
+
+        data.resize(offset + qMax<qint64>(read, 0));
+        d->addToDigests(data.constData() + offset, read, d->_digestOffset);
+
+        if (read < d->_blockSize) {
+            return data;
+        }
+    }
+}
+
+qint64 ReaderIterator::readChunk(char* data, qint64 maxSize)
+{
+    Q_D(ReaderIterator);
+    Q_ASSERT(d->_isValid);
+    d->_entryDataRead = true;
+
+    qint64 read = 0;
+    {
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Codec};
+        read = readFully(d->_archive, data, maxSize);
+    }
+
+    if (read < 0) {
+        d->_error = ReaderError::CannotReadData;
+    }
+
+    d->addToDigests(data, read, d->_digestOffset);
+    return read;
+}
+
+std::optional<ReaderDataBlock> ReaderIterator::readBlock()
+{
+    Q_D(ReaderIterator);
+    Q_ASSERT(d->_isValid);
+
+    const void* buffer = nullptr;
+    size_t size = 0;
+    la_int64_t offset = 0;
+    d->_entryDataRead = true;
+
+    int r = ARCHIVE_OK;
+    {
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Codec};
+        r = archive_read_data_block(d->_archive, &buffer, &size, &offset);
+    }
+
+    if (r == ARCHIVE_EOF) {
+        // A hole at the end of a sparse file.
+        if (std::optional<qint64> size = entry().size(); size && *size > d->_digestOffset) {
+            d->_digests.addZeros(*size - d->_digestOffset);
+            d->_digestOffset = *size;
+        }
+
+        return std::nullopt;
+    }
+
+    if (r < ARCHIVE_WARN) {
+        d->_error = ReaderError::CannotReadData;
+        return std::nullopt;
+    }
+
+    d->addToDigests(static_cast<const char*>(buffer), static_cast<qint64>(size), offset);
+
+    return ReaderDataBlock{
+        QByteArray::fromRawData(static_cast<const char*>(buffer), static_cast<int>(size)),
+        offset};
+}
+
+QList<ReaderDataBlock> ReaderIterator::readDataBlocks()
+{
+    QList<ReaderDataBlock> blocks;
+
+    while (std::optional<ReaderDataBlock> block = readBlock()) {
+        if (!blocks.isEmpty()
+            && blocks.last().offset + blocks.last().data.size() == block->offset) {
+            blocks.last().data.append(block->data);
+        } else {
+            // The block refers to libarchive's buffer, so it is copied.
+            blocks.push_back({QByteArray{block->data.constData(), block->data.size()},
+                              block->offset});
+        }
+    }
+
+    return blocks;
+}
+
+void ReaderIterator::setDigestAlgorithms(const QList<DigestAlgorithm>& algorithms)
+{
+    Q_D(ReaderIterator);
+    d->_digests.setAlgorithms(algorithms);
+    d->_digestOffset = 0;
+}
+
+Digests ReaderIterator::digests() const
+{
+    Q_D(const ReaderIterator);
+    return d->_digests.result();
+}
+
+Statistics ReaderIterator::statistics() const
+{
+    Q_D(const ReaderIterator);
+
+    if (d->_finalStatistics) {
+        return *d->_finalStatistics;
+    }
+
+    if (!d->_statistics) {
+        return {};
+    }
+
+    d->_statistics->updateFilters(d->_archive);
+    return d->_statistics->statistics();
 }
 
 ReaderError ReaderIterator::error() const
@@ -150,7 +739,40 @@ ReaderEntry ReaderIterator::entry() const
     return ReaderEntry{d->_archiveEntry};
 }
 
-ReaderIterator::ReaderIterator(const Reader* reader, qint64 blockSize)
-    : d_ptr{new ReaderIteratorPrivate{reader, blockSize}}
+qint64 ReaderIterator::headerPosition() const
+{
+    Q_D(const ReaderIterator);
+    Q_ASSERT(d->_isValid);
+    return archive_read_header_position(d->_archive);
+}
+
+ReaderIterator::ReaderIterator(
+    const Reader* reader, qint64 blockSize, qint64 startOffset, int formatCode)
+    : d_ptr{new ReaderIteratorPrivate{reader, blockSize, startOffset, formatCode}}
 {}
+
+ReaderIterator::ReaderIterator(std::unique_ptr<ReaderIteratorPrivate> d)
+    : d_ptr{std::move(d)}
+{}
+
+bool ReaderIterator::isSeekable() const
+{
+    Q_D(const ReaderIterator);
+
+    if (d->_archive == nullptr) {
+        return false;
+    }
+
+    // Headers of uncompressed tar and cpio archives are self-contained, so reading can start
+    // at any header offset.
+    int format = archive_format(d->_archive) & ARCHIVE_FORMAT_BASE_MASK;
+    return archive_filter_code(d->_archive, 0) == ARCHIVE_FILTER_NONE
+           && (format == ARCHIVE_FORMAT_TAR || format == ARCHIVE_FORMAT_CPIO);
+}
+
+int ReaderIterator::formatCode() const
+{
+    Q_D(const ReaderIterator);
+    return d->_archive != nullptr ? archive_format(d->_archive) : 0;
+}
 } // namespace QtLibArchive
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_READERITERATOR_P_H
+#define QTLIBARCHIVE_READERITERATOR_P_H
+
+#include <QtLibArchive/Reader.h>
+#include <QtLibArchive/ReaderIterator.h>
+
+#include <archive.h>
+
+#include "DigestCalculator_p.h"
+#include "ReadAheadBuffer_p.h"
+#include "StatisticsCollector_p.h"
+
+#include <QByteArray>
+#include <QFile>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+namespace QtLibArchive {
+/*!
+ * State of an open libarchive read handle.
+ *
+ * The Reader opens one of these when it is constructed to report errors early and hands it to
+ * the first ReaderIterator instead of opening the archive a second time.
+ */
+class ReaderIteratorPrivate
+{
+    friend class Reader;
+    friend class ReaderIterator;
+
+public:
+    ReaderIteratorPrivate(
+        const Reader* reader, qint64 blockSize, qint64 startOffset = 0, int formatCode = 0);
+    ~ReaderIteratorPrivate();
+
+private:
+    void supportConfiguredFormatsAndFilters(const Reader& reader);
+    [[nodiscard]] bool supportDetectedFormatAndFilters();
+    void rememberDetectedFormatAndFilters();
+
+    bool open(const Reader& reader, qint64 startOffset);
+    bool openDevice(QIODevice* device, qint64 startOffset, int readAheadBlocks = 0);
+    bool claimDevice(const Reader& reader);
+    void releaseDevice();
+
+    /*! Adds data of the current entry read at \a offset to the digests. */
+    void addToDigests(const char* data, qint64 size, qint64 offset) const;
+
+    [[nodiscard]] qint64 position() const;
+    bool seek(qint64 position);
+    [[nodiscard]] qint64 deviceSize() const;
+    [[nodiscard]] bool isSequential() const;
+
+    /*! Counts the current entry as skipped if none of its data was read. */
+    void countSkippedEntry();
+
+    /*!
+     * Collects statistics into \a total, or stops collecting them if it is null. Handles
+     * opened before statistics were enabled only count what they read from then on.
+     */
+    void setStatistics(std::shared_ptr<StatisticsAccumulator> total, StatisticsCallback callback);
+
+    /*! Hands the final statistics to the reader's sum and callback. Called once on close. */
+    void finishStatistics();
+
+    static la_ssize_t readCallback(archive* handle, void* clientData, const void** buffer);
+    static la_int64_t skipCallback(archive*, void* clientData, la_int64_t request);
+    static la_int64_t seekCallback(archive*, void* clientData, la_int64_t offset, int whence);
+
+    qint64 _blockSize{10240};
+    QByteArray _data;
+    std::shared_ptr<QFile> _mappedFile;
+    QFile _file;
+    QIODevice* _device{nullptr};
+    qint64 _deviceOffset{0};
+    qint64 _position{0};
+    std::shared_ptr<std::atomic<bool>> _deviceInUse;
+    QByteArray _buffer;
+    std::unique_ptr<ReadAheadBuffer> _readAhead;
+    qint64 _fixedBufferBytes{0};
+    archive* _archive{nullptr};
+    archive_entry* _archiveEntry{nullptr};
+    bool _isValid{false};
+    // Shared with the reader and its other handles; filled in on the first header.
+    std::shared_ptr<Reader::DetectedFormat> _detectedFormat;
+    bool _formatRecorded{false};
+
+    // Digests are updated by the const readData() as well.
+    mutable DigestCalculator _digests;
+    mutable qint64 _digestOffset{0};
+    mutable bool _entryDataRead{false};
+
+    std::unique_ptr<StatisticsCollector> _statistics;
+    std::shared_ptr<StatisticsAccumulator> _statisticsTotal;
+    StatisticsCallback _statisticsCallback;
+    std::optional<Statistics> _finalStatistics;
+    // The const readData() reports read errors as well.
+    mutable ReaderError _error{ReaderError::None};
+};
+} // namespace QtLibArchive
+
+#endif
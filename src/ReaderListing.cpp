@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include <QtLibArchive/ReaderListing.h>
+
+#include "Permissions_p.h"
+
+#include <QDir>
+
+#include <archive.h>
+#include <archive_entry.h>
+
+#include <cstring>
+
+namespace QtLibArchive {
+FileType ReaderListEntry::fileType() const
+{
+    return static_cast<FileType>(mode & AE_IFMT);
+}
+
+std::optional<QFile::Permissions> ReaderListEntry::permissions() const
+{
+    return hasPermissions ? std::make_optional(permissionsFromMode(mode)) : std::nullopt;
+}
+
+std::optional<QDateTime> ReaderListEntry::mtime() const
+{
+    return hasMtime ? std::make_optional(QDateTime::fromMSecsSinceEpoch(mtimeMSecs))
+                    : std::nullopt;
+}
+
+qint64 ReaderListing::count() const
+{
+    return static_cast<qint64>(_entries.size());
+}
+
+bool ReaderListing::isEmpty() const
+{
+    return _entries.empty();
+}
+
+bool ReaderListing::isComplete() const
+{
+    return _complete;
+}
+
+const ReaderListEntry& ReaderListing::at(qint64 index) const
+{
+    Q_ASSERT(index >= 0 && index < count());
+    return _entries[static_cast<size_t>(index)];
+}
+
+QByteArray ReaderListing::pathNameUtf8(const ReaderListEntry& entry) const
+{
+    return QByteArray::fromRawData(
+        _paths.constData() + entry.pathOffset, static_cast<int>(entry.pathLength));
+}
+
+QString ReaderListing::pathName(const ReaderListEntry& entry) const
+{
+    return QString::fromUtf8(
+        _paths.constData() + entry.pathOffset, static_cast<int>(entry.pathLength));
+}
+
+QString ReaderListing::cleanPathName(const ReaderListEntry& entry) const
+{
+    return QDir::cleanPath(pathName(entry));
+}
+
+ReaderListing::const_iterator ReaderListing::begin() const
+{
+    return _entries.cbegin();
+}
+
+ReaderListing::const_iterator ReaderListing::end() const
+{
+    return _entries.cend();
+}
+
+void ReaderListing::append(archive_entry* entry)
+{
+    ReaderListEntry record;
+
+    // The path bytes are copied straight into the arena without converting them.
+    const char* pathName = archive_entry_pathname(entry);
+    size_t pathLength = pathName != nullptr ? std::strlen(pathName) : 0;
+
+    record.pathOffset = _paths.size();
+    record.pathLength = static_cast<quint32>(pathLength);
+    _paths.append(pathName, static_cast<int>(pathLength));
+
+    if (archive_entry_size_is_set(entry)) {
+        record.size = archive_entry_size(entry);
+    }
+
+    if (archive_entry_mtime_is_set(entry)) {
+        record.hasMtime = true;
+        record.mtimeMSecs = static_cast<qint64>(archive_entry_mtime(entry)) * 1000
+                            + archive_entry_mtime_nsec(entry) / 1000000;
+    }
+
+    record.hasPermissions = archive_entry_perm_is_set(entry);
+    record.mode = static_cast<quint32>(archive_entry_mode(entry));
+
+    _entries.push_back(record);
+}
+
+void ReaderListing::squeeze()
+{
+    _paths.squeeze();
+    _entries.shrink_to_fit();
+}
+} // namespace QtLibArchive
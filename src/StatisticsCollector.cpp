@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#include "StatisticsCollector_p.h"
+
+#include <archive.h>
+
+namespace QtLibArchive {
+StatisticsCollector::Timer::Timer(StatisticsCollector* collector, Stage stage)
+    : _collector{collector}
+    , _stage{stage}
+{
+    if (_collector == nullptr) {
+        return;
+    }
+
+    const Statistics& statistics = _collector->_statistics;
+    _nestedBefore = statistics.ioNanoseconds + statistics.callbackNanoseconds;
+    _timer.start();
+}
+
+StatisticsCollector::Timer::~Timer()
+{
+    if (_collector == nullptr) {
+        return;
+    }
+
+    Statistics& statistics = _collector->_statistics;
+    qint64 elapsed = _timer.nsecsElapsed();
+
+    switch (_stage) {
+    case Stage::Io:
+        statistics.ioNanoseconds += elapsed;
+        break;
+    case Stage::Codec: {
+        qint64 nested = statistics.ioNanoseconds + statistics.callbackNanoseconds - _nestedBefore;
+        statistics.codecNanoseconds += qMax<qint64>(elapsed - nested, 0);
+        break;
+    }
+    case Stage::Callback:
+        statistics.callbackNanoseconds += elapsed;
+        break;
+    }
+}
+
+StatisticsCollector::StatisticsCollector()
+{
+    _elapsed.start();
+}
+
+void StatisticsCollector::addHeader()
+{
+    _statistics.headers++;
+}
+
+void StatisticsCollector::addSkippedEntry()
+{
+    _statistics.entriesSkipped++;
+}
+
+void StatisticsCollector::setFixedBufferBytes(qint64 bytes)
+{
+    _fixedBufferBytes = bytes;
+    _statistics.peakBufferBytes = qMax(_statistics.peakBufferBytes, bytes);
+}
+
+void StatisticsCollector::addTransientBuffer(qint64 bytes)
+{
+    _statistics.peakBufferBytes = qMax(_statistics.peakBufferBytes, _fixedBufferBytes + bytes);
+}
+
+void StatisticsCollector::updateFilters(archive* handle)
+{
+    if (handle == nullptr) {
+        return;
+    }
+
+    const int count = archive_filter_count(handle);
+    _statistics.filters.clear();
+
+    for (int i = 0; i < count; ++i) {
+        const char* name = archive_filter_name(handle, i);
+        _statistics.filters.push_back(
+            {QString::fromUtf8(name != nullptr ? name : ""), archive_filter_bytes(handle, i)});
+    }
+}
+
+Statistics StatisticsCollector::statistics() const
+{
+    Statistics result = _statistics;
+    result.elapsedNanoseconds = _elapsed.nsecsElapsed();
+
+    return result;
+}
+
+void StatisticsAccumulator::add(const Statistics& statistics)
+{
+    QMutexLocker locker{&_mutex};
+    _total += statistics;
+}
+
+Statistics StatisticsAccumulator::total() const
+{
+    QMutexLocker locker{&_mutex};
+    return _total;
+}
+} // namespace QtLibArchive
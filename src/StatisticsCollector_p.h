@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT
+// Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
+
+#ifndef QTLIBARCHIVE_STATISTICSCOLLECTOR_P_H
+#define QTLIBARCHIVE_STATISTICSCOLLECTOR_P_H
+
+#include <QtLibArchive/Statistics.h>
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+struct archive;
+
+namespace QtLibArchive {
+/*!
+ * Collects Statistics for one libarchive handle.
+ *
+ * Readers and writers only create one when statistics are enabled. The timers accept a null
+ * collector, so call sites need no checks of their own.
+ */
+class StatisticsCollector final
+{
+public:
+    enum class Stage { Io, Codec, Callback };
+
+    /*!
+     * Adds the time until it is destroyed to \a stage. Codec time excludes the I/O and
+     * callbacks libarchive triggers meanwhile, which are timed by nested timers.
+     */
+    class Timer final
+    {
+    public:
+        Timer(StatisticsCollector* collector, Stage stage);
+        Timer(const Timer&) = delete;
+        ~Timer();
+
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        StatisticsCollector* _collector{nullptr};
+        Stage _stage{Stage::Io};
+        qint64 _nestedBefore{0};
+        QElapsedTimer _timer;
+    };
+
+    StatisticsCollector();
+
+    void addHeader();
+    void addSkippedEntry();
+
+    /*! Sets the size of the buffers held for the whole lifetime of the handle. */
+    void setFixedBufferBytes(qint64 bytes);
+
+    /*! Records a buffer of \a bytes held in addition to the fixed buffers. */
+    void addTransientBuffer(qint64 bytes);
+
+    /*! Reads the byte counts of the filter chain of \a handle. */
+    void updateFilters(archive* handle);
+
+    [[nodiscard]] Statistics statistics() const;
+
+private:
+    Statistics _statistics;
+    qint64 _fixedBufferBytes{0};
+    QElapsedTimer _elapsed;
+};
+
+/*! Sums up the statistics of the handles a Reader opens, which may be closed on any thread. */
+class StatisticsAccumulator final
+{
+public:
+    void add(const Statistics& statistics);
+    [[nodiscard]] Statistics total() const;
+
+private:
+    mutable QMutex _mutex;
+    Statistics _total;
+};
+} // namespace QtLibArchive
+
+#endif
@@ -1,23 +1,292 @@
 // SPDX-License-Identifier: MIT
 // Copyright (C) 2025 sequality software engineering e.U. <office@sequality.at>
 
+#include <QtLibArchive/ParallelWriter.h>
 #include <QtLibArchive/Writer.h>
 
-#include <QBuffer>
+#include "DigestCalculator_p.h"
+#include "FileOutput_p.h"
+#include "FunctionRunnable_p.h"
+#include "StatisticsCollector_p.h"
+
+#include <QCryptographicHash>
+#include <QDir>
 #include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
 
 #include <archive.h>
+#include <archive_entry.h>
 
 namespace QtLibArchive {
+namespace {
+WriterEntry regularFileEntry(
+    const QString& pathInArchive, qint64 size, QFileDevice::Permissions permissions)
+{
+    WriterEntry archiveEntry;
+    archiveEntry.setFileType(FileType::Regular);
+    archiveEntry.setPathName(pathInArchive);
+    archiveEntry.setPermissions(permissions);
+    archiveEntry.setSize(size);
+
+    return archiveEntry;
+}
+
+/*! Number of bytes at the start of an entry the compression policy looks at. */
+constexpr qint64 CompressionSniffSize = 64 * 1024;
+
+bool hasCompressedSignature(const char* data, qint64 size)
+{
+    struct Signature
+    {
+        int offset;
+        const char* bytes;
+        int length;
+    };
+
+    static constexpr Signature Signatures[] = {
+        {0, "\xFF\xD8\xFF", 3},       // JPEG
+        {0, "\x89PNG", 4},            // PNG
+        {0, "GIF8", 4},               // GIF
+        {8, "WEBP", 4},               // WebP
+        {4, "ftyp", 4},               // MP4, MOV, HEIC
+        {0, "\x1A\x45\xDF\xA3", 4},   // Matroska, WebM
+        {0, "OggS", 4},               // Ogg
+        {0, "fLaC", 4},               // FLAC
+        {0, "ID3", 3},                // MP3
+        {0, "PK\x03\x04", 4},         // zip, jar, docx, apk
+        {0, "\x1F\x8B", 2},           // gzip
+        {0, "BZh", 3},                // bzip2
+        {0, "\xFD" "7zXZ\x00", 6},    // xz
+        {0, "\x28\xB5\x2F\xFD", 4},   // zstd
+        {0, "\x04\x22\x4D\x18", 4},   // lz4
+        {0, "7z\xBC\xAF\x27\x1C", 6}, // 7z
+        {0, "Rar!\x1A\x07", 6},       // rar
+    };
+
+    for (const Signature& signature : Signatures) {
+        if (size >= signature.offset + signature.length
+            && std::memcmp(data + signature.offset, signature.bytes, signature.length) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * Returns the Shannon entropy of \a data in bits per byte. Compressed and encrypted data is
+ * close to 8.
+ */
+double entropy(const char* data, qint64 size)
+{
+    std::array<qint64, 256> counts{};
+    for (qint64 i = 0; i < size; ++i) {
+        counts[static_cast<unsigned char>(data[i])]++;
+    }
+
+    double result = 0.0;
+    for (qint64 count : counts) {
+        if (count > 0) {
+            double p = static_cast<double>(count) / static_cast<double>(size);
+            result -= p * std::log2(p);
+        }
+    }
+
+    return result;
+}
+
+bool looksCompressed(const char* data, qint64 size)
+{
+    // Small samples do not say much about the distribution of the bytes.
+    constexpr qint64 MinEntropySampleSize = 4096;
+    constexpr double CompressedEntropy = 7.5;
+
+    if (hasCompressedSignature(data, size)) {
+        return true;
+    }
+
+    return size >= MinEntropySampleSize && entropy(data, size) > CompressedEntropy;
+}
+
+/*!
+ * Returns the data regions of \a file if it has holes, or an empty list otherwise.
+ *
+ * The regions are found with SEEK_DATA and SEEK_HOLE, where the platform supports them. The
+ * file must be positioned at its start and is left there.
+ */
+QList<SparseRegion> sparseRegions(QFileDevice* file)
+{
+    QList<SparseRegion> regions;
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    const int fd = file->handle();
+    const qint64 size = file->size();
+
+    if (fd < 0 || file->pos() != 0 || size <= 0) {
+        return regions;
+    }
+
+    qint64 position = 0;
+    while (position < size) {
+        off_t data = ::lseek(fd, static_cast<off_t>(position), SEEK_DATA);
+
+        // ENXIO: only a hole is left up to the end of the file.
+        if (data < 0) {
+            break;
+        }
+
+        off_t hole = ::lseek(fd, data, SEEK_HOLE);
+        if (hole < 0) {
+            regions.clear();
+            break;
+        }
+
+        regions.push_back({data, hole - data});
+        position = hole;
+    }
+
+    ::lseek(fd, 0, SEEK_SET);
+
+    // A single region covering the file means there are no holes.
+    if (regions.size() == 1 && regions.first().offset == 0 && regions.first().length >= size) {
+        regions.clear();
+    }
+#else
+    Q_UNUSED(file);
+#endif
+
+    return regions;
+}
+
+/*!
+ * Writes \a size bytes of \a device as a sparse entry. Holes are passed to libarchive as zeros
+ * without reading them, so formats that store holes neither read nor compress them.
+ */
+bool writeSparseData(
+    Writer& writer, QIODevice* device, qint64 size, const QList<SparseRegion>& regions)
+{
+    static const QByteArray Zeros(64 * 1024, '\0');
+    qint64 position = 0;
+
+    auto writeZeros = [&writer, &position](qint64 end) {
+        while (position < end) {
+            qint64 length = qMin<qint64>(end - position, Zeros.size());
+
+            if (!writer.writeData(Zeros.constData(), length)) {
+                return false;
+            }
+
+            position += length;
+        }
+
+        return true;
+    };
+
+    QByteArray buffer(static_cast<int>(writer.blockSize()), Qt::Uninitialized);
+
+    for (const SparseRegion& region : regions) {
+        if (!writeZeros(region.offset) || !device->seek(region.offset)) {
+            return false;
+        }
+
+        for (qint64 end = region.offset + region.length; position < end;) {
+            qint64 length = qMin<qint64>(end - position, buffer.size());
+            qint64 read = device->read(buffer.data(), length);
+
+            if (read <= 0 || !writer.writeData(buffer.constData(), read)) {
+                return false;
+            }
+
+            position += read;
+        }
+    }
+
+    return writeZeros(size);
+}
+
+/*!
+ * Returns the target of the symbolic link \a info as it is stored, without resolving it, so
+ * absolute targets and links to other links are kept.
+ */
+QString symlinkTarget(const QFileInfo& info)
+{
+#ifdef Q_OS_UNIX
+    QByteArray path = QFile::encodeName(info.filePath());
+    QByteArray target(256, Qt::Uninitialized);
+
+    for (;;) {
+        ssize_t length =
+            ::readlink(path.constData(), target.data(), static_cast<size_t>(target.size()));
+
+        if (length < 0) {
+            break;
+        }
+
+        // A target filling the buffer may have been truncated.
+        if (length < target.size()) {
+            return QFile::decodeName(target.left(static_cast<int>(length)));
+        }
+
+        target.resize(target.size() * 2);
+    }
+#endif
+
+    return info.dir().relativeFilePath(info.symLinkTarget());
+}
+
+/*!
+ * Lists the entries of \a path sorted by name and stats them, so that the file information is
+ * cached by the time the entries are written.
+ */
+QFileInfoList listDirectory(const QString& path, const QStringList& nameFilters)
+{
+    QDir dir{path};
+    constexpr QDir::Filters Common = QDir::NoDotAndDotDot | QDir::Hidden;
+
+    // AllDirs lists all directories regardless of the name filters. System adds broken links
+    // and special files, which must only be listed once.
+    QFileInfoList entries = dir.entryInfoList(QDir::AllDirs | Common, QDir::Unsorted);
+    entries += dir.entryInfoList(nameFilters, QDir::Files | QDir::System | Common, QDir::Unsorted);
+
+    std::sort(entries.begin(), entries.end(), [](const QFileInfo& lhs, const QFileInfo& rhs) {
+        return lhs.fileName() < rhs.fileName();
+    });
+
+    for (const QFileInfo& entry : entries) {
+        (void)entry.lastModified();
+        (void)entry.permissions();
+    }
+
+    return entries;
+}
+} // namespace
+
 class WriterPrivate
 {
     friend class Writer;
 
 public:
-    WriterPrivate(const QString& filePath, SupportedFormat format, QList<SupportedFilter> filters)
-        : _filePath{filePath}
-        , _format{format}
+    WriterPrivate(
+        SupportedFormat format, QList<SupportedFilter> filters, const WriterOptions& options)
+        : _format{format}
         , _filters{std::move(filters)}
+        , _options{options}
+        , _statistics{
+              options.collectStatistics || options.statisticsCallback
+                  ? std::make_unique<StatisticsCollector>()
+                  : nullptr}
         , _archive{archive_write_new()}
     {
         if (_archive == nullptr) {
@@ -38,6 +307,44 @@ public:
             }
         }
 
+        _digests.setAlgorithms(_options.digestAlgorithms);
+
+        if (!applyFilterOptions()) {
+            _error = WriterError::CannotSetFilterOption;
+            return;
+        }
+
+        if (!applyFormatOptions()) {
+            _error = WriterError::CannotSetFormatOption;
+            return;
+        }
+
+        // Entries left open by the policy must be able to return to this method.
+        if (choosesZipCompression() && _options.compressionMethod
+            && *_options.compressionMethod != CompressionMethod::Store
+            && *_options.compressionMethod != CompressionMethod::Deflate) {
+            _error = WriterError::CannotSetFormatOption;
+            return;
+        }
+    }
+
+    void openFile(const QString& filePath)
+    {
+        if (_error != WriterError::None) {
+            return;
+        }
+
+        _filePath = filePath;
+
+        // libarchive's own file handling cannot be timed, so statistics need the callbacks.
+        if (_options.writeBehindBlocks > 0 || _options.syncOnClose || _statistics) {
+            if (!openOutput()) {
+                _error = WriterError::CannotOpenFile;
+            }
+
+            return;
+        }
+
         std::wstring fileName = filePath.toStdWString();
         if (archive_write_open_filename_w(_archive, fileName.c_str()) != ARCHIVE_OK) {
             _error = WriterError::CannotOpenFile;
@@ -45,20 +352,576 @@ public:
         }
     }
 
+    void openData(QByteArray* data)
+    {
+        if (_error != WriterError::None) {
+            return;
+        }
+
+        Q_ASSERT(data != nullptr);
+        data->clear();
+        _data = data;
+
+        archive_write_set_bytes_in_last_block(_archive, 1);
+
+        if (archive_write_open(_archive, this, nullptr, dataWriteCallback, nullptr)
+            != ARCHIVE_OK) {
+            _error = WriterError::CannotOpenFile;
+        }
+    }
+
+    void openDevice(QIODevice* device)
+    {
+        if (_error != WriterError::None) {
+            return;
+        }
+
+        if (device == nullptr
+            || (!device->isOpen() && !device->open(QIODevice::WriteOnly))
+            || !device->isWritable()) {
+            _error = WriterError::CannotOpenFile;
+            return;
+        }
+
+        _device = device;
+        archive_write_set_bytes_in_last_block(_archive, 1);
+
+        if (archive_write_open(_archive, this, nullptr, deviceWriteCallback, deviceCloseCallback)
+            != ARCHIVE_OK) {
+            _error = WriterError::CannotOpenFile;
+        }
+    }
+
+    /*!
+     * Writes to a device such as a socket or QProcess. Sequential devices buffering the data
+     * themselves are given time to send it while too much is pending, so a slow receiver slows
+     * down the Writer rather than the buffer growing with the archive.
+     */
+    static la_ssize_t deviceWriteCallback(
+        archive* handle, void* clientData, const void* buffer, size_t length)
+    {
+        constexpr qint64 MaxPendingBytes = 1024 * 1024;
+        auto* d = static_cast<WriterPrivate*>(clientData);
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+
+        qint64 written =
+            d->_device->write(static_cast<const char*>(buffer), static_cast<qint64>(length));
+        if (written < 0) {
+            archive_set_error(
+                handle, ARCHIVE_ERRNO_MISC, "%s", qPrintable(d->_device->errorString()));
+            return -1;
+        }
+
+        if (!d->waitForDevice(handle, MaxPendingBytes)) {
+            return -1;
+        }
+
+        return static_cast<la_ssize_t>(written);
+    }
+
+    static int deviceCloseCallback(archive* handle, void* clientData)
+    {
+        auto* d = static_cast<WriterPrivate*>(clientData);
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+
+        // The device stays open. It belongs to the caller. Files, including QSaveFile, only
+        // write their buffer on flush(); waiting is meant for devices sending it by themselves.
+        if (auto* file = qobject_cast<QFileDevice*>(d->_device)) {
+            if (!file->flush()) {
+                archive_set_error(
+                    handle, ARCHIVE_ERRNO_MISC, "%s", qPrintable(file->errorString()));
+                return ARCHIVE_FATAL;
+            }
+
+            return ARCHIVE_OK;
+        }
+
+        return d->waitForDevice(handle, 0) ? ARCHIVE_OK : ARCHIVE_FATAL;
+    }
+
+    /*!
+     * Waits until a sequential device has at most \a maxPendingBytes left to send. Each wait
+     * is bounded by WriterOptions::deviceWriteTimeout, so a receiver that stopped reading
+     * fails the writer instead of blocking it forever.
+     */
+    bool waitForDevice(archive* handle, qint64 maxPendingBytes)
+    {
+        while (_device->isSequential() && _device->bytesToWrite() > maxPendingBytes) {
+            if (!_device->waitForBytesWritten(_options.deviceWriteTimeout)) {
+                _error = WriterError::CannotWriteData;
+                archive_set_error(
+                    handle, ARCHIVE_ERRNO_MISC, "%s", qPrintable(_device->errorString()));
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool openOutput()
+    {
+        _output = std::make_unique<FileOutput>(
+            _filePath, _options.writeBehindBlocks, _options.syncOnClose);
+
+        if (!_output->open()) {
+            return false;
+        }
+
+        // Like archive_write_open_filename() does for regular files, do not pad the last block.
+        archive_write_set_bytes_in_last_block(_archive, 1);
+        updateBufferStatistics();
+
+        return archive_write_open(_archive, this, nullptr, fileWriteCallback, fileCloseCallback)
+               == ARCHIVE_OK;
+    }
+
+    static la_ssize_t fileWriteCallback(
+        archive* handle, void* clientData, const void* buffer, size_t length)
+    {
+        auto* d = static_cast<WriterPrivate*>(clientData);
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+
+        if (!d->_output->write(static_cast<const char*>(buffer), static_cast<qint64>(length))) {
+            archive_set_error(
+                handle, ARCHIVE_ERRNO_MISC, "%s", qPrintable(d->_output->errorString()));
+            return -1;
+        }
+
+        return static_cast<la_ssize_t>(length);
+    }
+
+    static int fileCloseCallback(archive* handle, void* clientData)
+    {
+        auto* d = static_cast<WriterPrivate*>(clientData);
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+
+        if (!d->_output->close()) {
+            archive_set_error(
+                handle, ARCHIVE_ERRNO_MISC, "%s", qPrintable(d->_output->errorString()));
+            return ARCHIVE_FATAL;
+        }
+
+        return ARCHIVE_OK;
+    }
+
+    static la_ssize_t dataWriteCallback(
+        archive* handle, void* clientData, const void* buffer, size_t length)
+    {
+        // Qt 5 cannot grow a QByteArray to 2 GiB, as its header and terminator count as well.
+        constexpr qint64 MaxDataSize = std::numeric_limits<int>::max() - 1024;
+        auto* d = static_cast<WriterPrivate*>(clientData);
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+
+        if (d->_data->size() + static_cast<qint64>(length) > MaxDataSize) {
+            archive_set_error(
+                handle, ARCHIVE_ERRNO_MISC, "The archive exceeds the maximum QByteArray size");
+            return -1;
+        }
+
+        d->_data->append(static_cast<const char*>(buffer), static_cast<int>(length));
+
+        return static_cast<la_ssize_t>(length);
+    }
+
+    /*! Records the write-behind queue and the read buffer as the writer's fixed buffers. */
+    void updateBufferStatistics()
+    {
+        if (!_statistics) {
+            return;
+        }
+
+        qint64 queueBytes = 0;
+        if (_output && _archive != nullptr) {
+            queueBytes = static_cast<qint64>(_options.writeBehindBlocks)
+                         * archive_write_get_bytes_per_block(_archive);
+        }
+
+        _statistics->setFixedBufferBytes(queueBytes + _buffer.size());
+    }
+
+    /*! Reports the final statistics to the callback, once the archive is closed. */
+    void finishStatistics()
+    {
+        if (_statistics && _options.statisticsCallback) {
+            _options.statisticsCallback(_statistics->statistics());
+        }
+    }
+
+    bool applyFilterOptions()
+    {
+        for (SupportedFilter filter : _filters) {
+            const char* module = filterName(filter);
+            if (module == nullptr) {
+                continue;
+            }
+
+            if (_options.compressionLevel && supportsCompressionLevel(filter)
+                && !setFilterOption(module, "compression-level", *_options.compressionLevel)) {
+                return false;
+            }
+
+            if (_options.compressionThreads
+                && (filter == SupportedFilter::Xz || filter == SupportedFilter::Zstd)
+                && !setFilterOption(module, "threads", *_options.compressionThreads)) {
+                return false;
+            }
+
+            if (_options.lz4BlockSize && filter == SupportedFilter::Lz4
+                && !setFilterOption(module, "block-size", *_options.lz4BlockSize)) {
+                return false;
+            }
+        }
+
+        for (const WriterOption& option : _options.filterOptions) {
+            QByteArray module = option.module.toUtf8();
+            QByteArray key = option.key.toUtf8();
+            QByteArray value = option.value.toUtf8();
+
+            if (archive_write_set_filter_option(
+                    _archive,
+                    module.isEmpty() ? nullptr : module.constData(),
+                    key.constData(),
+                    value.isNull() ? nullptr : value.constData())
+                != ARCHIVE_OK) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool applyFormatOptions()
+    {
+        const char* module = formatName(_format);
+
+        // The zip format switches to deflate or store depending on the level, so the level goes
+        // first and the method overrides it.
+        if (module != nullptr && _options.compressionMethodLevel
+            && !setFormatOption(
+                module,
+                "compression-level",
+                QByteArray::number(*_options.compressionMethodLevel).constData())) {
+            return false;
+        }
+
+        if (module != nullptr && _options.compressionMethod) {
+            const char* method = compressionMethodName(*_options.compressionMethod, _format);
+            if (!setFormatOption(module, "compression", method)) {
+                return false;
+            }
+        }
+
+        // Without a value the option is unset, i.e. zip64 extensions are never written.
+        if (_format == SupportedFormat::Zip && _options.zip64
+            && !setFormatOption("zip", "zip64", *_options.zip64 ? "1" : nullptr)) {
+            return false;
+        }
+
+        if (_options.paxXattrHeader
+            && (_format == SupportedFormat::TarPaxInterchange
+                || _format == SupportedFormat::TarPaxRestricted)
+            && !setFormatOption(
+                "pax", "xattrheader", paxXattrHeaderName(*_options.paxXattrHeader))) {
+            return false;
+        }
+
+        for (const WriterOption& option : _options.formatOptions) {
+            QByteArray optionModule = option.module.toUtf8();
+            QByteArray key = option.key.toUtf8();
+            QByteArray value = option.value.toUtf8();
+
+            if (!setFormatOption(
+                    optionModule.isEmpty() ? nullptr : optionModule.constData(),
+                    key.constData(),
+                    value.isNull() ? nullptr : value.constData())) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*!
+     * Applies the compression policy to the next entry, \a pathInArchive, whose data starts
+     * with \a head. libarchive picks up the zip compression method when the header is written.
+     */
+    void selectCompression(const QString& pathInArchive, const char* head, qint64 size)
+    {
+        if (_error != WriterError::None || !choosesZipCompression()) {
+            return;
+        }
+
+        size = qMin(size, CompressionSniffSize);
+        std::optional<CompressionMethod> method;
+
+        if (_options.compressionPolicy) {
+            StatisticsCollector::Timer timer{
+                _statistics.get(), StatisticsCollector::Stage::Callback};
+            method = _options.compressionPolicy(
+                pathInArchive, QByteArray::fromRawData(head, static_cast<int>(size)));
+        }
+
+        if (!method && _options.storeIncompressible && looksCompressed(head, size)) {
+            method = CompressionMethod::Store;
+        }
+
+        // Entries left open return to the method the archive was opened with.
+        if (!method && _entryCompression) {
+            method = _options.compressionMethod.value_or(CompressionMethod::Deflate);
+        }
+
+        if (!method || method == _entryCompression) {
+            return;
+        }
+
+        if (!setZipCompression(*method)) {
+            _error = WriterError::CannotSetFormatOption;
+            return;
+        }
+
+        _entryCompression = method;
+    }
+
+    bool choosesZipCompression() const
+    {
+        return _format == SupportedFormat::Zip
+               && (_options.compressionPolicy || _options.storeIncompressible);
+    }
+
+    /*!
+     * Switches the compression of the following zip entries. Format options are only accepted
+     * before the archive is opened, so only store and deflate can be chosen per entry.
+     */
+    bool setZipCompression(CompressionMethod method)
+    {
+        switch (method) {
+        case CompressionMethod::Store:
+            return archive_write_zip_set_compression_store(_archive) == ARCHIVE_OK;
+        case CompressionMethod::Deflate:
+            return archive_write_zip_set_compression_deflate(_archive) == ARCHIVE_OK;
+        default:
+            return false;
+        }
+    }
+
+    bool setFormatOption(const char* module, const char* key, const char* value)
+    {
+        return archive_write_set_format_option(_archive, module, key, value) == ARCHIVE_OK;
+    }
+
+    bool setFilterOption(const char* module, const char* key, int value)
+    {
+        QByteArray valueStr = QByteArray::number(value);
+        return archive_write_set_filter_option(_archive, module, key, valueStr.constData())
+               == ARCHIVE_OK;
+    }
+
+    static bool supportsCompressionLevel(SupportedFilter filter)
+    {
+        switch (filter) {
+        case SupportedFilter::Gzip:
+        case SupportedFilter::Bzip2:
+        case SupportedFilter::Lzma:
+        case SupportedFilter::Xz:
+        case SupportedFilter::Lzip:
+        case SupportedFilter::Lrzip:
+        case SupportedFilter::Lzop:
+        case SupportedFilter::Lz4:
+        case SupportedFilter::Zstd:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /*!
+     * Returns the path of an earlier entry with the content \a digest, or records \a path for
+     * it while the index stays below WriterOptions::deduplicationMemoryLimit.
+     */
+    std::optional<QString> duplicateOf(const QByteArray& digest, const QString& path)
+    {
+        auto found = _contentIndex.constFind(digest);
+        if (found != _contentIndex.constEnd()) {
+            return *found;
+        }
+
+        // Rough heap usage of a hash node with its key and value.
+        qint64 cost = digest.size() + path.size() * 2 + 64;
+
+        if (_contentIndexBytes + cost <= _options.deduplicationMemoryLimit) {
+            _contentIndex.insert(digest, path);
+            _contentIndexBytes += cost;
+        }
+
+        return std::nullopt;
+    }
+
+    /*! Only tar stores hard links as references to the data of an earlier entry. */
+    bool supportsDeduplication() const
+    {
+        return _options.deduplicate
+               && (static_cast<int>(_format) & 0xFF0000) == static_cast<int>(SupportedFormat::Tar);
+    }
+
+    /*!
+     * Returns the name of the format module taking the compression options, or nullptr if
+     * the format does not compress its entries.
+     */
+    static const char* formatName(SupportedFormat format)
+    {
+        switch (format) {
+        case SupportedFormat::Zip:
+            return "zip";
+        case SupportedFormat::SevenZip:
+            return "7zip";
+        default:
+            return nullptr;
+        }
+    }
+
+    /*! Returns the value of the compression option of \a format selecting \a method. */
+    static const char* compressionMethodName(CompressionMethod method, SupportedFormat format)
+    {
+        switch (method) {
+        case CompressionMethod::Store:
+            return "store";
+        case CompressionMethod::Deflate:
+            return "deflate";
+        case CompressionMethod::Bzip2:
+            return "bzip2";
+        case CompressionMethod::Lzma:
+            return format == SupportedFormat::SevenZip ? "lzma1" : "lzma";
+        case CompressionMethod::Lzma2:
+            return "lzma2";
+        case CompressionMethod::Ppmd:
+            return "ppmd";
+        case CompressionMethod::Xz:
+            return "xz";
+        case CompressionMethod::Zstd:
+            return "zstd";
+        }
+
+        return nullptr;
+    }
+
+    /*! Returns the value of the pax xattrheader option selecting \a header. */
+    static const char* paxXattrHeaderName(PaxXattrHeader header)
+    {
+        switch (header) {
+        case PaxXattrHeader::All:
+            return "ALL";
+        case PaxXattrHeader::Schily:
+            return "SCHILY";
+        case PaxXattrHeader::Libarchive:
+            return "LIBARCHIVE";
+        }
+
+        return nullptr;
+    }
+
+    /*! Returns the module name libarchive uses for the options of \a filter. */
+    static const char* filterName(SupportedFilter filter)
+    {
+        switch (filter) {
+        case SupportedFilter::Gzip:
+            return "gzip";
+        case SupportedFilter::Bzip2:
+            return "bzip2";
+        case SupportedFilter::Compress:
+            return "compress";
+        case SupportedFilter::Lzma:
+            return "lzma";
+        case SupportedFilter::Xz:
+            return "xz";
+        case SupportedFilter::Uu:
+            return "uuencode";
+        case SupportedFilter::Lzip:
+            return "lzip";
+        case SupportedFilter::Lrzip:
+            return "lrzip";
+        case SupportedFilter::Lzop:
+            return "lzop";
+        case SupportedFilter::Grzip:
+            return "grzip";
+        case SupportedFilter::Lz4:
+            return "lz4";
+        case SupportedFilter::Zstd:
+            return "zstd";
+        default:
+            return nullptr;
+        }
+    }
+
     QString _filePath;
     SupportedFormat _format{SupportedFormat::Empty};
     QList<SupportedFilter> _filters;
+    WriterOptions _options;
     WriterError _error{WriterError::None};
     qint64 _fileCount{0};
     qint64 _blockSize{10240};
+    std::optional<CompressionMethod> _entryCompression;
+    qint64 _entrySize{-1};
+    qint64 _entryBytesWritten{0};
+    QByteArray _buffer;
+    std::unique_ptr<FileOutput> _output;
+    QByteArray* _data{nullptr};
+    QIODevice* _device{nullptr};
+    std::unique_ptr<StatisticsCollector> _statistics;
+    DigestCalculator _digests;
+    QHash<QByteArray, QString> _contentIndex;
+    qint64 _contentIndexBytes{0};
 
     archive* _archive{nullptr};
 };
 
-Writer::Writer(const QString& filePath, SupportedFormat format, SupportedFilter filter)
-    : d_ptr{new WriterPrivate{filePath, format, {filter}}}
+Writer::Writer(
+    const QString& filePath,
+    SupportedFormat format,
+    SupportedFilter filter,
+    const WriterOptions& options)
+    : Writer{filePath, format, QList<SupportedFilter>{filter}, options}
+{}
+
+Writer::Writer(
+    QByteArray* data, SupportedFormat format, SupportedFilter filter, const WriterOptions& options)
+    : Writer{data, format, QList<SupportedFilter>{filter}, options}
 {}
 
+Writer::Writer(
+    QIODevice* device, SupportedFormat format, SupportedFilter filter, const WriterOptions& options)
+    : Writer{device, format, QList<SupportedFilter>{filter}, options}
+{}
+
+Writer::Writer(
+    const QString& filePath,
+    SupportedFormat format,
+    const QList<SupportedFilter>& filters,
+    const WriterOptions& options)
+    : d_ptr{new WriterPrivate{format, filters, options}}
+{
+    d_ptr->openFile(filePath);
+}
+
+Writer::Writer(
+    QByteArray* data,
+    SupportedFormat format,
+    const QList<SupportedFilter>& filters,
+    const WriterOptions& options)
+    : d_ptr{new WriterPrivate{format, filters, options}}
+{
+    d_ptr->openData(data);
+}
+
+Writer::Writer(
+    QIODevice* device,
+    SupportedFormat format,
+    const QList<SupportedFilter>& filters,
+    const WriterOptions& options)
+    : d_ptr{new WriterPrivate{format, filters, options}}
+{
+    d_ptr->openDevice(device);
+}
+
 Writer::~Writer()
 {
     close();
@@ -77,18 +940,38 @@ bool Writer::writeHeader(const WriterEntry& entry)
         return false;
     }
 
-    int r = archive_write_header(d->_archive, entry._entry);
+    int r = ARCHIVE_OK;
+    {
+        StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Codec};
+        r = archive_write_header(d->_archive, entry._entry);
+    }
 
+    // Writing the header may flush earlier data, whose failure is already reported.
     if (r != ARCHIVE_OK) {
-        d->_error = WriterError::CannotWriteHeader;
+        if (d->_error == WriterError::None) {
+            d->_error = WriterError::CannotWriteHeader;
+        }
+
         return false;
     }
 
+    if (d->_statistics) {
+        d->_statistics->addHeader();
+    }
+
     d->_fileCount++;
+    d->_entrySize = archive_entry_size_is_set(entry._entry) ? archive_entry_size(entry._entry) : -1;
+    d->_entryBytesWritten = 0;
+    d->_digests.reset();
     return true;
 }
 
 bool Writer::writeData(const QByteArray& data)
+{
+    return writeData(data.constData(), data.size());
+}
+
+bool Writer::writeData(const char* data, qint64 size)
 {
     Q_D(Writer);
 
@@ -96,13 +979,26 @@ bool Writer::writeData(const QByteArray& data)
         return false;
     }
 
-    int written = archive_write_data(d->_archive, data.constData(), data.size());
+    StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Codec};
+    qint64 total = 0;
+
+    while (total < size) {
+        la_ssize_t written = archive_write_data(d->_archive, data + total, size - total);
+
+        if (written <= 0) {
+            break;
+        }
 
-    if (written != data.size()) {
+        total += written;
+    }
+
+    if (total != size) {
         d->_error = WriterError::CannotWriteData;
         return false;
     }
 
+    d->_entryBytesWritten += size;
+    d->_digests.addData(data, size);
     return true;
 }
 
@@ -114,12 +1010,53 @@ bool Writer::writeData(QIODevice* device)
         return false;
     }
 
-    while (!device->atEnd()) {
-        QByteArray data = device->read(d->_blockSize);
+    // The buffer is reused across blocks and entries instead of allocating one per block.
+    if (d->_buffer.size() != d->_blockSize) {
+        d->_buffer.resize(d->_blockSize);
+        d->updateBufferStatistics();
+    }
 
-        if (!writeData(data)) {
+    // Reading more than the entry holds would consume data following it on a sequential device.
+    auto remaining = [d]() -> qint64 {
+        return d->_entrySize >= 0 ? d->_entrySize - d->_entryBytesWritten : -1;
+    };
+
+    while (remaining() != 0) {
+        qint64 length = remaining() > 0 ? qMin<qint64>(remaining(), d->_buffer.size())
+                                         : d->_buffer.size();
+        qint64 read = 0;
+        bool ready = true;
+
+        {
+            StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Io};
+            read = device->read(d->_buffer.data(), length);
+
+            // Sequential devices like sockets may not have the next block yet. Random-access
+            // devices are at their end.
+            if (read == 0) {
+                ready = device->isSequential()
+                        && device->waitForReadyRead(d->_options.deviceReadTimeout);
+            }
+        }
+
+        if (read < 0) {
+            d->_error = WriterError::CannotWriteData;
             return false;
         }
+
+        if (!ready) {
+            break;
+        }
+
+        if (read > 0 && !writeData(d->_buffer.constData(), read)) {
+            return false;
+        }
+    }
+
+    // libarchive would pad a short entry with zeros.
+    if (remaining() > 0) {
+        d->_error = WriterError::CannotWriteData;
+        return false;
     }
 
     return true;
@@ -133,6 +1070,7 @@ bool Writer::finishEntry()
         return false;
     }
 
+    StatisticsCollector::Timer timer{d->_statistics.get(), StatisticsCollector::Stage::Codec};
     return archive_write_finish_entry(d->_archive) == ARCHIVE_OK;
 }
 
@@ -161,35 +1099,280 @@ bool Writer::addFile(
         return false;
     }
 
-    WriterEntry archiveEntry;
-    archiveEntry.setFileType(FileType::Regular);
-    archiveEntry.setPathName(pathInArchive);
-    archiveEntry.setPermissions(permissions);
-    archiveEntry.setSize(device->size());
+    WriterEntry archiveEntry = regularFileEntry(pathInArchive, device->size(), permissions);
 
     if (!device->isOpen() && !device->open(QIODevice::ReadOnly)) {
         d->_error = WriterError::CannotOpenFile;
         return false;
     }
 
-    if (!writeHeader(archiveEntry)) {
+    return writeFile(archiveEntry, device);
+}
+
+bool Writer::addFile(
+    const QString& pathInArchive, const QByteArray& data, QFileDevice::Permissions permissions)
+{
+    Q_D(Writer);
+
+    if (d->_error != WriterError::None) {
+        return false;
+    }
+
+    WriterEntry archiveEntry = regularFileEntry(pathInArchive, data.size(), permissions);
+    return writeFile(archiveEntry, data);
+}
+
+bool Writer::addHardlink(
+    const QString& pathInArchive, const QString& target, QFileDevice::Permissions permissions)
+{
+    WriterEntry archiveEntry = regularFileEntry(pathInArchive, 0, permissions);
+    archiveEntry.setHardlink(target);
+
+    return writeHeader(archiveEntry);
+}
+
+bool Writer::addTree(const QString& rootPath, const QStringList& nameFilters, int threads)
+{
+    Q_D(Writer);
+
+    if (d->_error != WriterError::None) {
         return false;
     }
 
-    if (!writeData(device)) {
+    QDir root{rootPath};
+    if (!root.exists()) {
+        d->_error = WriterError::CannotOpenFile;
         return false;
     }
 
-    return true;
+    // Directories are listed level by level, all directories of a level in parallel. They are
+    // keyed by their path relative to the root.
+    QHash<QString, QFileInfoList> children;
+    QStringList level{QString{}};
+    QMutex mutex;
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(threads, 1));
+
+    auto relativePath = [](const QString& directory, const QFileInfo& info) {
+        return directory.isEmpty() ? info.fileName() : directory + '/' + info.fileName();
+    };
+
+    while (!level.isEmpty()) {
+        QStringList nextLevel;
+
+        for (const QString& directory : level) {
+            pool.start(new FunctionRunnable{[&, directory]() {
+                QFileInfoList entries = listDirectory(root.filePath(directory), nameFilters);
+
+                QMutexLocker locker{&mutex};
+                for (const QFileInfo& info : entries) {
+                    if (info.isDir() && !info.isSymLink()) {
+                        nextLevel.push_back(relativePath(directory, info));
+                    }
+                }
+
+                children.insert(directory, std::move(entries));
+            }});
+        }
+
+        pool.waitForDone();
+        level = std::move(nextLevel);
+    }
+
+    // Files this large are streamed on this thread instead of being held in memory.
+    constexpr qint64 LargeFileSize = 16 * 1024 * 1024;
+    ParallelWriter parallelWriter{this, threads};
+
+    std::function<bool(const QString&)> addChildren = [&](const QString& directory) {
+        for (const QFileInfo& info : children.value(directory)) {
+            WriterEntry entry;
+            entry.setPathName(relativePath(directory, info));
+            entry.setPermissions(info.permissions());
+
+            // Broken symbolic links have no modification time.
+            if (info.lastModified().isValid()) {
+                entry.setMtime(info.lastModified());
+            }
+
+            if (info.isSymLink()) {
+                entry.setFileType(FileType::Link);
+                entry.setSymlink(symlinkTarget(info));
+
+                if (!parallelWriter.addEntry(std::move(entry))) {
+                    return false;
+                }
+            } else if (info.isDir()) {
+                entry.setFileType(FileType::Dir);
+
+                if (!parallelWriter.addEntry(std::move(entry))
+                    || !addChildren(relativePath(directory, info))) {
+                    return false;
+                }
+            } else if (info.isFile() && info.size() > LargeFileSize) {
+                entry.setFileType(FileType::Regular);
+                entry.setSize(info.size());
+
+                QFile file{info.filePath()};
+                if (!parallelWriter.finish() || !file.open(QIODevice::ReadOnly)) {
+                    return false;
+                }
+
+                if (!writeFile(entry, &file)) {
+                    return false;
+                }
+            } else if (info.isFile()) {
+                entry.setFileType(FileType::Regular);
+
+                if (!parallelWriter.addFile(std::move(entry), info.filePath())) {
+                    return false;
+                }
+            }
+
+            // Sockets and other special files are skipped.
+        }
+
+        return true;
+    };
+
+    bool ok = addChildren(QString{}) && parallelWriter.finish();
+
+    if (!ok && d->_error == WriterError::None) {
+        d->_error = parallelWriter.error() != WriterError::None ? parallelWriter.error()
+                                                                 : WriterError::CannotOpenFile;
+    }
+
+    return ok;
 }
 
-bool Writer::addFile(
-    const QString& pathInArchive, const QByteArray& data, QFileDevice::Permissions permissions)
+bool Writer::writeFile(WriterEntry& entry, const QByteArray& data)
 {
-    QBuffer buffer;
-    buffer.setData(data);
+    Q_D(Writer);
+
+    std::optional<Digests> digests;
+
+    if (d->_options.storeDigests && !d->_digests.isEmpty()) {
+        DigestCalculator calculator;
+        calculator.setAlgorithms(d->_options.digestAlgorithms);
+        calculator.addData(data.constData(), data.size());
+        digests = calculator.result();
 
-    return addFile(pathInArchive, &buffer, permissions);
+        for (auto it = digests->cbegin(); it != digests->cend(); ++it) {
+            archive_entry_xattr_add_entry(
+                entry._entry,
+                DigestCalculator::attributeName(it.key()),
+                it.value().constData(),
+                static_cast<size_t>(it.value().size()));
+        }
+    }
+
+    std::optional<QString> original;
+
+    if (d->supportsDeduplication() && !data.isEmpty()) {
+        // The stored SHA-256 digest identifies the content as well, if there is one.
+        QByteArray digest = digests ? digests->value(DigestAlgorithm::Sha256) : QByteArray{};
+
+        if (digest.isEmpty()) {
+            digest = QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+        }
+
+        original = d->duplicateOf(digest, entry.pathName().value_or(QString{}));
+    }
+
+    // A duplicate is stored as a link that keeps the attributes of the entry, including the
+    // stored digests. Otherwise the data is handed to libarchive directly instead of copying
+    // it through a QBuffer.
+    if (original) {
+        entry.setHardlink(*original);
+        entry.setSize(0);
+    } else {
+        entry.setSize(data.size());
+        d->selectCompression(entry.pathName().value_or(QString{}), data.constData(), data.size());
+    }
+
+    if (!writeHeader(entry)) {
+        return false;
+    }
+
+    // The data was hashed for the header already. The digests of a link still describe the
+    // content of the entry.
+    if (digests) {
+        d->_digests.setResult(*digests);
+    } else if (original) {
+        d->_digests.addData(data.constData(), data.size());
+    }
+
+    return original || writeData(data.constData(), data.size());
+}
+
+bool Writer::writeFile(WriterEntry& entry, QIODevice* device)
+{
+    Q_D(Writer);
+
+    // Hashing the content up front costs a read, but a duplicate is then neither compressed
+    // nor stored. Sequential devices cannot be read twice.
+    if (d->supportsDeduplication() && !device->isSequential() && device->size() > 0) {
+        qint64 start = device->pos();
+        QCryptographicHash hash{QCryptographicHash::Sha256};
+        DigestCalculator digests;
+        digests.setAlgorithms(d->_options.digestAlgorithms);
+
+        if (d->_buffer.size() != d->_blockSize) {
+            d->_buffer.resize(d->_blockSize);
+        }
+
+        qint64 read = 0;
+        while ((read = device->read(d->_buffer.data(), d->_buffer.size())) > 0) {
+            hash.addData(d->_buffer.constData(), static_cast<int>(read));
+            digests.addData(d->_buffer.constData(), read);
+        }
+
+        if (read < 0 || !device->seek(start)) {
+            d->_error = WriterError::CannotWriteData;
+            return false;
+        }
+
+        std::optional<QString> original
+            = d->duplicateOf(hash.result(), entry.pathName().value_or(QString{}));
+
+        if (original) {
+            entry.setHardlink(*original);
+            entry.setSize(0);
+
+            if (!writeHeader(entry)) {
+                return false;
+            }
+
+            // The digests still describe the content of the entry.
+            d->_digests.setResult(digests.result());
+            return true;
+        }
+    }
+
+    QByteArray head = device->peek(CompressionSniffSize);
+    d->selectCompression(entry.pathName().value_or(QString{}), head.constData(), head.size());
+
+    // Holes are recorded in the entry so that formats supporting it skip them.
+    auto* file = qobject_cast<QFileDevice*>(device);
+    QList<SparseRegion> regions = file != nullptr ? sparseRegions(file) : QList<SparseRegion>{};
+
+    for (const SparseRegion& region : regions) {
+        entry.addSparseRegion(region.offset, region.length);
+    }
+
+    if (!writeHeader(entry)) {
+        return false;
+    }
+
+    if (!regions.isEmpty()) {
+        if (!writeSparseData(*this, device, entry.size().value_or(0), regions)) {
+            d->_error = WriterError::CannotWriteData;
+            return false;
+        }
+
+        return true;
+    }
+
+    return writeData(device);
 }
 
 void Writer::close()
@@ -197,9 +1380,25 @@ void Writer::close()
     Q_D(Writer);
 
     if (d->_archive) {
-        archive_write_close(d->_archive);
+        int r = ARCHIVE_OK;
+        {
+            StatisticsCollector::Timer timer{
+                d->_statistics.get(), StatisticsCollector::Stage::Codec};
+            r = archive_write_close(d->_archive);
+        }
+
+        // With write-behind, errors writing the last blocks only show up here.
+        if (r != ARCHIVE_OK && d->_error == WriterError::None) {
+            d->_error = WriterError::CannotWriteData;
+        }
+
+        if (d->_statistics) {
+            d->_statistics->updateFilters(d->_archive);
+        }
+
         archive_write_free(d->_archive);
         d->_archive = nullptr;
+        d->finishStatistics();
     }
 }
 
@@ -209,6 +1408,40 @@ WriterError Writer::error() const
     return d->_error;
 }
 
+qint64 Writer::fileCount() const
+{
+    Q_D(const Writer);
+    return d->_fileCount;
+}
+
+Digests Writer::digests() const
+{
+    Q_D(const Writer);
+    return d->_digests.result();
+}
+
+Statistics Writer::statistics() const
+{
+    Q_D(const Writer);
+
+    if (!d->_statistics) {
+        return {};
+    }
+
+    // After close() the counts of the filters are final.
+    if (d->_archive != nullptr) {
+        d->_statistics->updateFilters(d->_archive);
+    }
+
+    return d->_statistics->statistics();
+}
+
+bool Writer::looksCompressed(const QByteArray& head)
+{
+    return QtLibArchive::looksCompressed(
+        head.constData(), qMin<qint64>(head.size(), CompressionSniffSize));
+}
+
 qint64 Writer::blockSize() const
 {
     Q_D(const Writer);
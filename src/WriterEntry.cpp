@@ -80,6 +80,26 @@ void WriterEntry::setPermissions(QFileDevice::Permissions permissions)
     archive_entry_set_perm(_entry, mode);
 }
 
+void WriterEntry::addSparseRegion(qint64 offset, qint64 length)
+{
+    Q_ASSERT(_entry != nullptr);
+    archive_entry_sparse_add_entry(_entry, offset, length);
+}
+
+void WriterEntry::setHardlink(const QString& target)
+{
+    QByteArray utf8Data = target.toUtf8();
+    Q_ASSERT(_entry != nullptr);
+    archive_entry_set_hardlink_utf8(_entry, utf8Data.constData());
+}
+
+void WriterEntry::setSymlink(const QString& target)
+{
+    QByteArray utf8Data = target.toUtf8();
+    Q_ASSERT(_entry != nullptr);
+    archive_entry_set_symlink_utf8(_entry, utf8Data.constData());
+}
+
 void WriterEntry::setMtime(const QDateTime& mtime)
 {
     Q_ASSERT(_entry != nullptr);
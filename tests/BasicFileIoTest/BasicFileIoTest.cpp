@@ -3,12 +3,80 @@
 
 #include <QtTest>
 
+#include <QSaveFile>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
 
+#include <QtLibArchive/ParallelWriter.h>
 #include <QtLibArchive/Reader.h>
+#include <QtLibArchive/ReaderEntryDevice.h>
 #include <QtLibArchive/Writer.h>
 
+#include <cstring>
+
+namespace {
+/*! Serves a byte array like a socket: once read, the data is gone. */
+class SequentialDevice : public QIODevice
+{
+public:
+    explicit SequentialDevice(QByteArray data)
+        : _data{std::move(data)}
+    {}
+
+    bool isSequential() const override { return true; }
+
+    qint64 bytesAvailable() const override
+    {
+        return _data.size() - _offset + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override
+    {
+        qint64 length = qMin(maxSize, _data.size() - _offset);
+        std::memcpy(data, _data.constData() + _offset, static_cast<size_t>(length));
+        _offset += length;
+
+        return length;
+    }
+
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    QByteArray _data;
+    qint64 _offset{0};
+};
+
+/*! Accepts data like a socket whose peer stopped reading: none of it is ever sent. */
+class StalledDevice : public QIODevice
+{
+public:
+    bool isSequential() const override { return true; }
+    qint64 bytesToWrite() const override { return _pending; }
+
+    bool waitForBytesWritten(int msecs) override
+    {
+        _lastTimeout = msecs;
+        return false;
+    }
+
+    int lastTimeout() const { return _lastTimeout; }
+
+protected:
+    qint64 readData(char*, qint64) override { return -1; }
+
+    qint64 writeData(const char*, qint64 size) override
+    {
+        _pending += size;
+        return size;
+    }
+
+private:
+    qint64 _pending{0};
+    int _lastTimeout{0};
+};
+} // namespace
+
 class BasicFileIoTest : public QObject
 {
     Q_OBJECT
@@ -18,6 +86,33 @@ private slots:
     void testFilePermissions();
     void testUtf8FileNames();
     void testTimeStamps();
+    void testIndexedFileData();
+    void testFilesData();
+    void testReadChunkAndBlock();
+    void testReaderEntryDevice();
+    void testReadFromMemoryAndDevice();
+    void testFirstIteratorAdoptsProbeHandle();
+    void testDetectedFormatIsCached();
+    void testExtractParallel();
+    void testFilterOptions();
+    void testWriteDataInPieces();
+    void testParallelWriter();
+    void testReadAhead();
+    void testWriteBehind();
+    void testAddTree();
+    void testExtractTo();
+    void testExtractMaliciousArchive();
+    void testSparseFiles();
+    void testList();
+    void testDigests();
+    void testDeduplication();
+    void testAddTreeDeduplication();
+    void testWriteToMemoryAndDevice();
+    void testWriteToStalledDevice();
+    void testFilterChainAndFormatOptions();
+    void testCompressionPolicy();
+    void testStatistics();
+    void testSequentialDeviceStatistics();
 };
 
 void BasicFileIoTest::testCreateTarArchiveAndRead()
@@ -232,6 +327,1504 @@ void BasicFileIoTest::testTimeStamps()
     }
 }
 
+void BasicFileIoTest::testIndexedFileData()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QStringList pathNames{"a.txt", "dir/b.txt", "dir/c.txt"};
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::None};
+
+        for (const QString& pathName : pathNames) {
+            QVERIFY(writer.addFile(pathName, pathName.toUtf8()));
+        }
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    QVERIFY(reader.buildIndex());
+    QVERIFY(reader.hasIndex());
+    QCOMPARE(reader.fileCount(), pathNames.size());
+
+    for (const QString& pathName : pathNames) {
+        QCOMPARE(reader.fileData("./" + pathName), pathName.toUtf8());
+    }
+
+    QVERIFY(!reader.fileData("missing.txt").has_value());
+
+    QList<QtLibArchive::ReaderIndexEntry> entries
+        = reader.indexEntries({"dir/c.txt", "missing.txt", "a.txt"});
+    QCOMPARE(entries.size(), 2);
+    QCOMPARE(entries[0].pathName, "a.txt");
+    QCOMPARE(entries[0].index, 0);
+    QCOMPARE(entries[1].pathName, "dir/c.txt");
+    QCOMPARE(entries[1].size, pathNames[2].size());
+    QVERIFY(reader.isFileCountExact());
+
+    QByteArray truncatedData = archive.readAll();
+    truncatedData.truncate(1536);
+
+    QtLibArchive::Reader truncatedReader = QtLibArchive::Reader::fromData(truncatedData);
+    QCOMPARE(truncatedReader.error(), QtLibArchive::ReaderError::None);
+    QVERIFY(truncatedReader.fileCount() < pathNames.size());
+    QVERIFY(!truncatedReader.isFileCountExact());
+}
+
+void BasicFileIoTest::testFilesData()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::Zip,
+            QtLibArchive::SupportedFilter::None};
+
+        for (int i = 0; i < 10; ++i) {
+            QString pathName = QString{"file%1.txt"}.arg(i);
+            QVERIFY(writer.addFile(pathName, pathName.toUtf8()));
+        }
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    QHash<QString, QByteArray> data
+        = reader.filesData({"file7.txt", "./file2.txt", "missing.txt"});
+    QCOMPARE(data.size(), 2);
+    QCOMPARE(data.value("file2.txt"), "file2.txt");
+    QCOMPARE(data.value("file7.txt"), "file7.txt");
+
+    QStringList visited;
+    QVERIFY(reader.filesData(
+        {"file3.txt", "file1.txt"},
+        [&visited](const QString& pathName, QtLibArchive::ReaderIterator&) {
+            visited << pathName;
+        }));
+    QCOMPARE(visited, (QStringList{"file1.txt", "file3.txt"}));
+}
+
+void BasicFileIoTest::testReadChunkAndBlock()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QByteArray data(100000, Qt::Uninitialized);
+    std::generate(data.begin(), data.end(), []() -> char {
+        return static_cast<char>(QRandomGenerator::global()->bounded(256));
+    });
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::Tar,
+            QtLibArchive::SupportedFilter::None};
+        QVERIFY(writer.addFile("data.bin", data));
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+
+    auto chunkIt = reader.iterator();
+    QVERIFY(chunkIt.next());
+
+    QByteArray chunks;
+    char buffer[4096];
+    qint64 read = 0;
+
+    while ((read = chunkIt.readChunk(buffer, sizeof(buffer))) > 0) {
+        chunks.append(buffer, static_cast<int>(read));
+    }
+
+    QCOMPARE(read, 0);
+    QCOMPARE(chunks, data);
+    QCOMPARE(chunkIt.error(), QtLibArchive::ReaderError::None);
+
+    auto blockIt = reader.iterator();
+    QVERIFY(blockIt.next());
+
+    QByteArray blocks;
+    while (std::optional<QtLibArchive::ReaderDataBlock> block = blockIt.readBlock()) {
+        QCOMPARE(block->offset, blocks.size());
+        blocks.append(block->data);
+    }
+
+    QCOMPARE(blocks, data);
+    QCOMPARE(blockIt.error(), QtLibArchive::ReaderError::None);
+
+    // The data of the entry ends in the middle, which is an error rather than its end.
+    QTemporaryFile truncatedArchive;
+    QVERIFY(truncatedArchive.open());
+    QVERIFY(truncatedArchive.write(archive.readAll().left(512 + data.size() / 2)) > 0);
+    QVERIFY(truncatedArchive.flush());
+
+    QtLibArchive::Reader truncated{truncatedArchive.fileName()};
+
+    auto truncatedChunkIt = truncated.iterator();
+    QVERIFY(truncatedChunkIt.next());
+
+    QByteArray whole(data.size(), Qt::Uninitialized);
+    QCOMPARE(truncatedChunkIt.readChunk(whole.data(), whole.size()), -1);
+    QCOMPARE(truncatedChunkIt.error(), QtLibArchive::ReaderError::CannotReadData);
+
+    auto truncatedBlockIt = truncated.iterator();
+    QVERIFY(truncatedBlockIt.next());
+
+    while (truncatedBlockIt.readBlock()) {
+    }
+
+    QCOMPARE(truncatedBlockIt.error(), QtLibArchive::ReaderError::CannotReadData);
+
+    auto truncatedDataIt = truncated.iterator();
+    QVERIFY(truncatedDataIt.next());
+    QVERIFY(truncatedDataIt.readData().isEmpty());
+    QCOMPARE(truncatedDataIt.error(), QtLibArchive::ReaderError::CannotReadData);
+}
+
+void BasicFileIoTest::testReaderEntryDevice()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QStringList lines;
+    for (int i = 0; i < 5000; ++i) {
+        lines << QString{"line %1"}.arg(i);
+    }
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::Gzip};
+        QVERIFY(writer.addFile("lines.txt", lines.join('\n').toUtf8()));
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    QtLibArchive::ReaderIterator iterator = reader.iterator();
+    QVERIFY(iterator.next().has_value());
+
+    QtLibArchive::ReaderEntryDevice device{&iterator};
+    QVERIFY(device.open(QIODevice::ReadOnly | QIODevice::Text));
+    QCOMPARE(device.size(), lines.join('\n').toUtf8().size());
+
+    QTextStream stream{&device};
+    QStringList readLines;
+    while (!stream.atEnd()) {
+        readLines << stream.readLine();
+    }
+
+    QCOMPARE(readLines, lines);
+    QVERIFY(device.atEnd());
+    device.close();
+    QVERIFY(!device.open(QIODevice::WriteOnly));
+}
+
+void BasicFileIoTest::testReadFromMemoryAndDevice()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::Zip,
+            QtLibArchive::SupportedFilter::None};
+        QVERIFY(writer.addFile("a.txt", QByteArray{"first"}));
+        QVERIFY(writer.addFile("b.txt", QByteArray{"second"}));
+    }
+
+    QByteArray archiveData = archive.readAll();
+    QVERIFY(!archiveData.isEmpty());
+
+    QtLibArchive::Reader memoryReader = QtLibArchive::Reader::fromData(archiveData);
+    QCOMPARE(memoryReader.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(memoryReader.fileCount(), 2);
+    QCOMPARE(memoryReader.fileData("b.txt"), "second");
+
+    QBuffer buffer{&archiveData};
+    QtLibArchive::Reader deviceReader = QtLibArchive::Reader::fromDevice(&buffer);
+    QCOMPARE(deviceReader.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(deviceReader.fileData("a.txt"), "first");
+    QCOMPARE(deviceReader.fileData("b.txt"), "second");
+
+    // Iterators sharing the device each continue from their own position.
+    QtLibArchive::ReaderIterator outer = deviceReader.iterator();
+    QVERIFY(outer.next());
+    QCOMPARE(deviceReader.fileData("b.txt"), "second");
+    QCOMPARE(outer.readData(), "first");
+    QVERIFY(outer.next());
+    QCOMPARE(outer.readData(), "second");
+
+    // A sequential device can only be read by one iterator at a time.
+    SequentialDevice sequential{archiveData};
+    QtLibArchive::Reader sequentialReader = QtLibArchive::Reader::fromDevice(&sequential);
+    QCOMPARE(sequentialReader.error(), QtLibArchive::ReaderError::None);
+
+    QtLibArchive::ReaderIterator first = sequentialReader.iterator();
+    QCOMPARE(first.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(sequentialReader.iterator().error(), QtLibArchive::ReaderError::DeviceInUse);
+
+    QVERIFY(first.next());
+    QCOMPARE(first.readData(), "first");
+
+    QtLibArchive::Reader mappedReader{
+        QtLibArchive::SupportedFormat::All, QtLibArchive::SupportedFilter::All};
+    QVERIFY(mappedReader.openMapped(archive.fileName()));
+    QVERIFY(mappedReader.isMapped());
+    QCOMPARE(mappedReader.fileData("a.txt"), "first");
+
+    // Iterators keep the mapping when the reader is reopened.
+    auto mappedIt = mappedReader.iterator();
+    QVERIFY(mappedIt.next());
+    QVERIFY(mappedReader.open(archive.fileName()));
+    QVERIFY(!mappedReader.isMapped());
+    QCOMPARE(mappedIt.readData(), "first");
+}
+
+void BasicFileIoTest::testFirstIteratorAdoptsProbeHandle()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.filePath("archive.tar");
+
+    {
+        QtLibArchive::Writer writer{
+            fileName,
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::None};
+        QVERIFY(writer.addFile("a.txt", QByteArray{"first"}));
+    }
+
+    QtLibArchive::Reader reader{fileName};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    // Only the handle opened on construction still sees the file.
+    if (!QFile::remove(fileName)) {
+        QSKIP("Open files cannot be removed on this platform");
+    }
+
+    QtLibArchive::ReaderIterator first = reader.iterator();
+    QCOMPARE(first.error(), QtLibArchive::ReaderError::None);
+    QVERIFY(first.next());
+    QCOMPARE(first.readData(), "first");
+
+    QtLibArchive::ReaderIterator second = reader.iterator();
+    QCOMPARE(second.error(), QtLibArchive::ReaderError::CannotOpenFile);
+}
+
+void BasicFileIoTest::testDetectedFormatIsCached()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.filePath("archive");
+
+    {
+        QtLibArchive::Writer writer{
+            fileName,
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::Gzip};
+        QVERIFY(writer.addFile("a.txt", QByteArray{"first"}));
+    }
+
+    QtLibArchive::Reader reader{fileName};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    // The first iterator records what it detected, even if the reader is gone by then.
+    QtLibArchive::ReaderIterator first = reader.iterator();
+    QtLibArchive::Reader copy = reader;
+    reader = QtLibArchive::Reader{fileName};
+    QVERIFY(first.next());
+    QCOMPARE(first.readData(), "first");
+    first.close();
+
+    {
+        QVERIFY(QFile::remove(fileName));
+        QtLibArchive::Writer writer{
+            fileName, QtLibArchive::SupportedFormat::Zip, QtLibArchive::SupportedFilter::None};
+        QVERIFY(writer.addFile("a.txt", QByteArray{"second"}));
+    }
+
+    // Later iterators only register the cached tar format and gzip filter.
+    QCOMPARE(copy.iterator().error(), QtLibArchive::ReaderError::CannotOpenFile);
+
+    QtLibArchive::Reader fresh{fileName};
+    QCOMPARE(fresh.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(fresh.fileData("a.txt"), "second");
+
+void BasicFileIoTest::testExtractParallel()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QHash<QString, QByteArray> expected;
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::Zip,
+            QtLibArchive::SupportedFilter::None};
+
+        for (int i = 0; i < 50; ++i) {
+            QString pathName = QString{"dir/file%1.bin"}.arg(i);
+            QByteArray data = pathName.toUtf8().repeated(i * 100 + 1);
+            expected.insert(pathName, data);
+            QVERIFY(writer.addFile(pathName, data));
+        }
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    QMutex mutex;
+    QHash<QString, QByteArray> extracted;
+
+    QVERIFY(reader.extractParallel(
+        {},
+        [&mutex, &extracted](
+            const QtLibArchive::ReaderIndexEntry& entry, QtLibArchive::ReaderIterator& iterator) {
+            QByteArray data = iterator.readData();
+            QMutexLocker locker{&mutex};
+            extracted.insert(entry.pathName, data);
+            return true;
+        },
+        4));
+
+    QCOMPARE(extracted, expected);
+
+    QVERIFY(!reader.extractParallel(
+        {"dir/file1.bin", "missing.bin"},
+        [](const QtLibArchive::ReaderIndexEntry&, QtLibArchive::ReaderIterator&) { return true; },
+        4));
+
+    // A device cannot be shared by the workers, so it is read on the calling thread.
+    QFile device{archive.fileName()};
+    QVERIFY(device.open(QIODevice::ReadOnly));
+
+    QtLibArchive::Reader deviceReader = QtLibArchive::Reader::fromDevice(&device);
+    QHash<QString, QByteArray> deviceExtracted;
+    QThread* caller = QThread::currentThread();
+
+    QVERIFY(deviceReader.extractParallel(
+        {},
+        [&deviceExtracted, caller](
+            const QtLibArchive::ReaderIndexEntry& entry, QtLibArchive::ReaderIterator& iterator) {
+            deviceExtracted.insert(entry.pathName, iterator.readData());
+            return QThread::currentThread() == caller;
+        },
+        4));
+
+    QCOMPARE(deviceExtracted, expected);
+}
+
+void BasicFileIoTest::testFilterOptions()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QByteArray testData = QByteArray{"compressible "}.repeated(1000);
+
+    {
+        QtLibArchive::WriterOptions options;
+        options.compressionLevel = 9;
+
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::Gzip,
+            options};
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+        QVERIFY(writer.addFile("test.txt", testData));
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(reader.fileData("test.txt"), testData);
+
+    QtLibArchive::WriterOptions invalidOptions;
+    invalidOptions.compressionLevel = 42;
+
+    QtLibArchive::Writer invalidWriter{
+        archive.fileName(),
+        QtLibArchive::SupportedFormat::TarPaxRestricted,
+        QtLibArchive::SupportedFilter::Gzip,
+        invalidOptions};
+    QCOMPARE(invalidWriter.error(), QtLibArchive::WriterError::CannotSetFilterOption);
+
+    // Only xz and zstd compress on several threads, gzip ignores the option.
+    QtLibArchive::WriterOptions threadedOptions;
+    threadedOptions.compressionLevel = 19;
+    threadedOptions.compressionThreads = 4;
+
+    QTemporaryFile threaded;
+    QVERIFY(threaded.open());
+
+    {
+        QtLibArchive::Writer writer{
+            threaded.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::Zstd,
+            threadedOptions};
+
+        if (writer.error() == QtLibArchive::WriterError::CannotAddFilter) {
+            QSKIP("libarchive was built without zstd support");
+        }
+
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+        QVERIFY(writer.addFile("test.txt", testData));
+    }
+
+    QtLibArchive::Reader threadedReader{threaded.fileName()};
+    QCOMPARE(threadedReader.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(threadedReader.fileData("test.txt"), testData);
+}
+
+void BasicFileIoTest::testWriteDataInPieces()
+{
+    QByteArray first = QByteArray{"first "}.repeated(5000);
+    QByteArray second = QByteArray{"second "}.repeated(5000);
+
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    {
+        QtLibArchive::WriterOptions options;
+        options.collectStatistics = true;
+
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::Tar,
+            QtLibArchive::SupportedFilter::None,
+            options};
+
+        QtLibArchive::WriterEntry entry;
+        entry.setFileType(QtLibArchive::FileType::Regular);
+        entry.setPathName("pieces.txt");
+        entry.setSize(first.size());
+        QVERIFY(writer.writeHeader(entry));
+        QVERIFY(writer.writeData(first.constData(), 1000));
+        QVERIFY(writer.writeData(first.constData() + 1000, first.size() - 1000));
+
+        // Entries spanning several blocks are read through the one buffer of the writer.
+        QBuffer firstDevice{&first};
+        QBuffer secondDevice{&second};
+        QVERIFY(writer.addFile("first.txt", &firstDevice));
+        QVERIFY(writer.addFile("second.txt", &secondDevice));
+
+        writer.close();
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+        QCOMPARE(writer.statistics().peakBufferBytes, writer.blockSize());
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.fileData("pieces.txt"), first);
+    QCOMPARE(reader.fileData("first.txt"), first);
+    QCOMPARE(reader.fileData("second.txt"), second);
+
+    // A device ending before the size in the header fails instead of leaving a padded entry.
+    QByteArray shortData{"short"};
+    QBuffer shortDevice{&shortData};
+    QVERIFY(shortDevice.open(QIODevice::ReadOnly));
+
+    QTemporaryFile failedArchive;
+    QVERIFY(failedArchive.open());
+
+    QtLibArchive::Writer failing{
+        failedArchive.fileName(),
+        QtLibArchive::SupportedFormat::Tar,
+        QtLibArchive::SupportedFilter::None};
+    QtLibArchive::WriterEntry entry;
+    entry.setFileType(QtLibArchive::FileType::Regular);
+    entry.setPathName("short.txt");
+    entry.setSize(100);
+    QVERIFY(failing.writeHeader(entry));
+    QVERIFY(!failing.writeData(&shortDevice));
+    QCOMPARE(failing.error(), QtLibArchive::WriterError::CannotWriteData);
+}
+
+void BasicFileIoTest::testParallelWriter()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QList<QPair<QString, QByteArray>> expected;
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::Zip,
+            QtLibArchive::SupportedFilter::None};
+        QtLibArchive::ParallelWriter parallelWriter{&writer, 4, 4096};
+
+        QtLibArchive::WriterEntry dirEntry;
+        dirEntry.setFileType(QtLibArchive::FileType::Dir);
+        dirEntry.setPathName("dir/");
+        dirEntry.setPermissions(QtLibArchive::Writer::defaultDirectoryPermissions());
+        QVERIFY(parallelWriter.addEntry(std::move(dirEntry)));
+
+        for (int i = 0; i < 50; ++i) {
+            QString pathName = QString{"dir/file%1.bin"}.arg(i);
+            QByteArray data = pathName.toUtf8().repeated(i * 10 + 1);
+            expected.append({pathName, data});
+
+            QFile file{dir.filePath(QString{"file%1.bin"}.arg(i))};
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            QCOMPARE(file.write(data), data.size());
+            file.close();
+
+            QVERIFY(parallelWriter.addFile(pathName, file.fileName()));
+        }
+
+        QVERIFY(parallelWriter.finish());
+        QCOMPARE(writer.fileCount(), 51);
+
+        QVERIFY(!parallelWriter.addFile("missing.bin", dir.filePath("missing.bin")));
+        QVERIFY(!parallelWriter.finish());
+        QCOMPARE(parallelWriter.error(), QtLibArchive::WriterError::CannotOpenFile);
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    // Entries are committed in the order they were added.
+    QtLibArchive::ReaderIterator it = reader.iterator();
+    std::optional<QtLibArchive::ReaderEntry> entry = it.next();
+    QVERIFY(entry);
+    QCOMPARE(entry->pathName(), QString{"dir/"});
+
+    for (const auto& [pathName, data] : expected) {
+        entry = it.next();
+        QVERIFY(entry);
+        QCOMPARE(entry->pathName(), pathName);
+        QCOMPARE(it.readData(), data);
+    }
+}
+
+void BasicFileIoTest::testReadAhead()
+{
+    for (auto [format, filter] : {
+             std::pair{QtLibArchive::SupportedFormat::Zip, QtLibArchive::SupportedFilter::None},
+             std::pair{
+                 QtLibArchive::SupportedFormat::TarPaxRestricted,
+                 QtLibArchive::SupportedFilter::Gzip}}) {
+        QTemporaryFile archive;
+        QVERIFY(archive.open());
+
+        QList<QPair<QString, QByteArray>> expected;
+
+        {
+            QtLibArchive::Writer writer{archive.fileName(), format, filter};
+
+            for (int i = 0; i < 20; ++i) {
+                QString pathName = QString{"file%1.bin"}.arg(i);
+                QByteArray data = pathName.toUtf8().repeated(i * 1000 + 1);
+                expected.append({pathName, data});
+                QVERIFY(writer.addFile(pathName, data));
+            }
+        }
+
+        QtLibArchive::Reader reader{archive.fileName()};
+        QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+        reader.setReadAhead(4);
+        QCOMPARE(reader.readAhead(), 4);
+
+        QtLibArchive::ReaderIterator it = reader.iterator();
+
+        for (const auto& [pathName, data] : expected) {
+            std::optional<QtLibArchive::ReaderEntry> entry = it.next();
+            QVERIFY(entry);
+            QCOMPARE(entry->pathName(), pathName);
+            QCOMPARE(it.readData(), data);
+        }
+
+        QVERIFY(!it.next());
+        QCOMPARE(it.error(), QtLibArchive::ReaderError::None);
+
+        // Skipping entries seeks behind the read-ahead stage.
+        QCOMPARE(reader.fileData("file17.bin"), expected[17].second);
+    }
+}
+
+void BasicFileIoTest::testWriteBehind()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QHash<QString, QByteArray> expected;
+
+    {
+        QtLibArchive::WriterOptions options;
+        options.writeBehindBlocks = 2;
+        options.syncOnClose = true;
+
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::Gzip,
+            options};
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+
+        for (int i = 0; i < 20; ++i) {
+            QString pathName = QString{"file%1.bin"}.arg(i);
+            QByteArray data = pathName.toUtf8().repeated(i * 1000 + 1);
+            expected.insert(pathName, data);
+            QVERIFY(writer.addFile(pathName, data));
+        }
+
+        writer.close();
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(reader.filesData(expected.keys()), expected);
+}
+
+void BasicFileIoTest::testAddTree()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QDir root{dir.path()};
+    QVERIFY(root.mkpath("sub/deeper"));
+
+    auto writeFile = [&root](const QString& path, const QByteArray& data) {
+        QFile file{root.filePath(path)};
+        return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+    };
+
+    QVERIFY(writeFile("b.txt", "bravo"));
+    QVERIFY(writeFile("a.txt", "alpha"));
+    QVERIFY(writeFile("skipped.log", "log"));
+    QVERIFY(writeFile("sub/c.txt", "charlie"));
+    QVERIFY(writeFile("sub/deeper/d.txt", "delta"));
+#ifdef Q_OS_UNIX
+    QVERIFY(QFile::link("a.txt", root.filePath("link.txt")));
+    QVERIFY(QFile::link("link.txt", root.filePath("chained.txt")));
+    QVERIFY(QFile::link(root.filePath("b.txt"), root.filePath("absolute.txt")));
+#endif
+
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::None};
+        QVERIFY(writer.addTree(dir.path(), {"*.txt"}, 4));
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    QStringList pathNames;
+    QHash<QString, QByteArray> data;
+    QHash<QString, QString> symlinks;
+    auto it = reader.iterator();
+
+    while (auto entry = it.next()) {
+        // Tar writes directories with a trailing slash.
+        pathNames.push_back(*entry->cleanPathName());
+
+        if (entry->fileType() == QtLibArchive::FileType::Regular) {
+            data.insert(*entry->cleanPathName(), it.readData());
+        } else if (entry->fileType() == QtLibArchive::FileType::Link) {
+            symlinks.insert(*entry->cleanPathName(), entry->symlink().value_or(QString{}));
+        }
+    }
+
+    QStringList expectedPathNames{
+        "a.txt", "b.txt", "sub", "sub/c.txt", "sub/deeper", "sub/deeper/d.txt"};
+#ifdef Q_OS_UNIX
+    expectedPathNames.insert(1, "absolute.txt");
+    expectedPathNames.insert(3, "chained.txt");
+    expectedPathNames.insert(4, "link.txt");
+
+    // Links are stored as they are, not resolved.
+    QHash<QString, QString> expectedSymlinks{
+        {"link.txt", "a.txt"},
+        {"chained.txt", "link.txt"},
+        {"absolute.txt", root.filePath("b.txt")}};
+    QCOMPARE(symlinks, expectedSymlinks);
+#endif
+
+    QCOMPARE(pathNames, expectedPathNames);
+    QCOMPARE(data.value("sub/deeper/d.txt"), "delta");
+    QCOMPARE(data.value("a.txt"), "alpha");
+}
+
+void BasicFileIoTest::testExtractTo()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QByteArray largeData = QByteArray{"large "}.repeated(10000);
+    QDateTime mtime = QDateTime::fromSecsSinceEpoch(1600000000);
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::Gzip};
+        QVERIFY(writer.addDirectory("dir"));
+        QVERIFY(writer.addFile("dir/small.txt", QByteArray{"small"}));
+        QVERIFY(writer.addFile("dir/nested/large.txt", largeData));
+
+        QtLibArchive::WriterEntry entry;
+        entry.setFileType(QtLibArchive::FileType::Regular);
+        entry.setPathName("executable.sh");
+        entry.setPermissions(
+            QtLibArchive::Writer::defaultRegularFilePermissions() | QFileDevice::ExeOwner);
+        entry.setMtime(mtime);
+        entry.setSize(4);
+        QVERIFY(writer.writeHeader(entry));
+        QVERIFY(writer.writeData(QByteArray{"exit"}));
+
+        QVERIFY(writer.addFile("../outside.txt", QByteArray{"outside"}));
+    }
+
+    QTemporaryDir parent;
+    QVERIFY(parent.isValid());
+    QString target = QDir{parent.path()}.filePath("target");
+
+    QtLibArchive::ExtractOptions options;
+    options.threads = 2;
+    options.smallFileSize = 1024;
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    // The entry leaving the target directory makes the extraction fail, but is only skipped.
+    QVERIFY(!reader.extractTo(target, options));
+    QVERIFY(!QFile::exists(QDir{parent.path()}.filePath("outside.txt")));
+
+    QFile small{QDir{target}.filePath("dir/small.txt")};
+    QVERIFY(small.open(QIODevice::ReadOnly));
+    QCOMPARE(small.readAll(), "small");
+
+    QFile large{QDir{target}.filePath("dir/nested/large.txt")};
+    QVERIFY(large.open(QIODevice::ReadOnly));
+    QCOMPARE(large.readAll(), largeData);
+
+    QFileInfo executable{QDir{target}.filePath("executable.sh")};
+    QVERIFY(executable.permissions().testFlag(QFileDevice::ExeOwner));
+    QCOMPARE(executable.lastModified(), mtime);
+}
+
+void BasicFileIoTest::testExtractMaliciousArchive()
+{
+#ifdef Q_OS_UNIX
+    QTemporaryDir parent;
+    QVERIFY(parent.isValid());
+    QDir parentDir{parent.path()};
+
+    QVERIFY(parentDir.mkpath("outside"));
+    QString victim = parentDir.filePath("outside/victim.txt");
+    {
+        QFile file{victim};
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("untouched");
+    }
+
+    // Links left behind in the target directory, e.g. by an earlier extraction.
+    QString target = parentDir.filePath("target");
+    QVERIFY(parentDir.mkpath("target"));
+    QVERIFY(QFile::link(parentDir.filePath("outside"), QDir{target}.filePath("escape")));
+    QVERIFY(QFile::link(victim, QDir{target}.filePath("existing.txt")));
+
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::None};
+
+        auto addSymlink = [&writer](const QString& path, const QString& linkTarget) {
+            QtLibArchive::WriterEntry entry;
+            entry.setFileType(QtLibArchive::FileType::Link);
+            entry.setPathName(path);
+            entry.setSymlink(linkTarget);
+            return writer.writeHeader(entry);
+        };
+
+        // A small file queued for the I/O threads, then replaced by a link to the victim.
+        QVERIFY(writer.addFile("queued.txt", QByteArray{"queued"}));
+        QVERIFY(addSymlink("queued.txt", victim));
+        QVERIFY(writer.addFile("queued.txt", QByteArray{"overwritten"}));
+
+        QVERIFY(writer.addFile("escape/victim.txt", QByteArray{"overwritten"}));
+        QVERIFY(writer.addFile("existing.txt", QByteArray{"replaced"}));
+
+        // Entries with the same path are written in archive order.
+        QVERIFY(writer.addFile("twice.txt", QByteArray{"first"}));
+        QVERIFY(writer.addFile("twice.txt", QByteArray{"second"}));
+    }
+
+    QtLibArchive::ExtractOptions options;
+    options.threads = 4;
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    // The entry below the link on disk is skipped, which makes the extraction fail.
+    QVERIFY(!reader.extractTo(target, options));
+
+    QFile victimFile{victim};
+    QVERIFY(victimFile.open(QIODevice::ReadOnly));
+    QCOMPARE(victimFile.readAll(), "untouched");
+
+    QFileInfo existing{QDir{target}.filePath("existing.txt")};
+    QVERIFY(!existing.isSymLink());
+
+    QFile existingFile{existing.filePath()};
+    QVERIFY(existingFile.open(QIODevice::ReadOnly));
+    QCOMPARE(existingFile.readAll(), "replaced");
+
+    QFile queued{QDir{target}.filePath("queued.txt")};
+    QVERIFY(queued.open(QIODevice::ReadOnly));
+    QCOMPARE(queued.readAll(), "overwritten");
+
+    QFile twice{QDir{target}.filePath("twice.txt")};
+    QVERIFY(twice.open(QIODevice::ReadOnly));
+    QCOMPARE(twice.readAll(), "second");
+#else
+    QSKIP("Creating symbolic links requires a Unix system");
+#endif
+}
+
+void BasicFileIoTest::testSparseFiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    constexpr qint64 Size = 4 * 1024 * 1024;
+    QByteArray expected(Size, '\0');
+    expected.replace(1024 * 1024, 4, "data");
+    expected.replace(3 * 1024 * 1024, 4, "more");
+
+    QFile source{QDir{dir.path()}.filePath("source.bin")};
+    QVERIFY(source.open(QIODevice::WriteOnly));
+    QVERIFY(source.resize(Size));
+    QVERIFY(source.seek(1024 * 1024));
+    QCOMPARE(source.write("data"), 4);
+    QVERIFY(source.seek(3 * 1024 * 1024));
+    QCOMPARE(source.write("more"), 4);
+    source.close();
+
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::None};
+        QVERIFY(writer.addFile("sparse.bin", &source));
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    {
+        auto it = reader.iterator();
+        auto entry = it.next();
+        QVERIFY(entry);
+        QCOMPARE(entry->size(), Size);
+
+        // Whether holes are found depends on the file system the test runs on.
+        QList<QtLibArchive::ReaderDataBlock> blocks = it.readDataBlocks();
+        qint64 dataSize = 0;
+
+        for (const QtLibArchive::ReaderDataBlock& block : blocks) {
+            QCOMPARE(block.data, expected.mid(block.offset, block.data.size()));
+            dataSize += block.data.size();
+        }
+
+        if (!entry->sparseRegions().isEmpty()) {
+            QVERIFY(dataSize < Size);
+            QVERIFY(archive.size() < Size);
+        } else {
+            QCOMPARE(dataSize, Size);
+        }
+    }
+
+    QVERIFY(reader.extractTo(QDir{dir.path()}.filePath("extracted")));
+
+    QFile extracted{QDir{dir.path()}.filePath("extracted/sparse.bin")};
+    QVERIFY(extracted.open(QIODevice::ReadOnly));
+    QCOMPARE(extracted.readAll(), expected);
+}
+
+void BasicFileIoTest::testList()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QDateTime mtime = QDateTime::fromSecsSinceEpoch(1600000000);
+
+    {
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::Gzip};
+        QVERIFY(writer.addDirectory("dir"));
+
+        QtLibArchive::WriterEntry entry;
+        entry.setFileType(QtLibArchive::FileType::Regular);
+        entry.setPathName("dir/file.txt");
+        entry.setPermissions(QtLibArchive::Writer::defaultRegularFilePermissions());
+        entry.setMtime(mtime);
+        entry.setSize(5);
+        QVERIFY(writer.writeHeader(entry));
+        QVERIFY(writer.writeData(QByteArray{"12345"}));
+
+        QVERIFY(writer.addFile("other.txt", QByteArray{"other"}));
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    QtLibArchive::ReaderListing listing = reader.list();
+    QVERIFY(listing.isComplete());
+    QCOMPARE(listing.count(), 3);
+
+    QCOMPARE(listing.cleanPathName(listing.at(0)), "dir");
+    QCOMPARE(listing.at(0).fileType(), QtLibArchive::FileType::Dir);
+
+    const QtLibArchive::ReaderListEntry& file = listing.at(1);
+    QCOMPARE(listing.pathName(file), "dir/file.txt");
+    QCOMPARE(listing.pathNameUtf8(file), "dir/file.txt");
+    QCOMPARE(file.fileType(), QtLibArchive::FileType::Regular);
+    QCOMPARE(file.size, 5);
+    QCOMPARE(file.mtime(), mtime);
+    QCOMPARE(file.permissions(), QtLibArchive::Writer::defaultRegularFilePermissions());
+
+    QStringList pathNames;
+    for (const QtLibArchive::ReaderListEntry& entry : listing) {
+        pathNames.push_back(listing.cleanPathName(entry));
+    }
+
+    QCOMPARE(pathNames, (QStringList{"dir", "dir/file.txt", "other.txt"}));
+}
+
+void BasicFileIoTest::testDigests()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QByteArray data = QByteArray{"digest me "}.repeated(5000);
+    QByteArray sha256 = QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+
+    // CRC-32 of "123456789" is the standard check value.
+    QByteArray check{"123456789"};
+    QByteArray checkCrc32 = QByteArray::fromHex("cbf43926");
+
+    {
+        QtLibArchive::WriterOptions options;
+        options.digestAlgorithms = {
+            QtLibArchive::DigestAlgorithm::Crc32, QtLibArchive::DigestAlgorithm::Sha256};
+        options.storeDigests = true;
+
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::None,
+            options};
+
+        QVERIFY(writer.addFile("data.txt", data));
+        QCOMPARE(writer.digests().value(QtLibArchive::DigestAlgorithm::Sha256), sha256);
+
+        QVERIFY(writer.addFile("check.txt", check));
+        QCOMPARE(writer.digests().value(QtLibArchive::DigestAlgorithm::Crc32), checkCrc32);
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    auto it = reader.iterator();
+    it.setDigestAlgorithms({QtLibArchive::DigestAlgorithm::Sha256});
+
+    auto entry = it.next();
+    QVERIFY(entry);
+    QCOMPARE(entry->storedDigests().value(QtLibArchive::DigestAlgorithm::Sha256), sha256);
+
+    QByteArray buffer(1000, Qt::Uninitialized);
+    while (it.readChunk(buffer.data(), buffer.size()) > 0) {
+    }
+
+    QCOMPARE(it.digests().value(QtLibArchive::DigestAlgorithm::Sha256), sha256);
+
+    entry = it.next();
+    QVERIFY(entry);
+    QCOMPARE(entry->storedDigests().value(QtLibArchive::DigestAlgorithm::Crc32), checkCrc32);
+    QCOMPARE(it.readData(), check);
+}
+
+void BasicFileIoTest::testDeduplication()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QByteArray data = QByteArray{"duplicate "}.repeated(10000);
+    QByteArray sha256 = QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+
+    {
+        QtLibArchive::WriterOptions options;
+        options.deduplicate = true;
+        options.digestAlgorithms = {QtLibArchive::DigestAlgorithm::Sha256};
+        options.storeDigests = true;
+
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::None,
+            options};
+        QVERIFY(writer.addFile("original.txt", data));
+        QVERIFY(writer.addFile("other.txt", QByteArray{"other"}));
+        QVERIFY(writer.addFile("copy.txt", data));
+        QCOMPARE(writer.digests().value(QtLibArchive::DigestAlgorithm::Sha256), sha256);
+
+        QBuffer buffer{&data};
+        QVERIFY(writer.addFile("device.txt", &buffer));
+        QCOMPARE(writer.digests().value(QtLibArchive::DigestAlgorithm::Sha256), sha256);
+
+        QVERIFY(writer.addHardlink("chain.txt", "copy.txt"));
+    }
+
+    // The duplicates are stored once.
+    QVERIFY(archive.size() < 2 * data.size());
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    auto it = reader.iterator();
+    QHash<QString, QString> hardlinks;
+    while (auto entry = it.next()) {
+        if (std::optional<QString> hardlink = entry->hardlink()) {
+            hardlinks.insert(*entry->pathName(), *hardlink);
+        }
+
+        // Links keep the digests of their content.
+        if (entry->pathName() == "copy.txt") {
+            QCOMPARE(entry->storedDigests().value(QtLibArchive::DigestAlgorithm::Sha256), sha256);
+        }
+    }
+
+    QCOMPARE(hardlinks.size(), 3);
+    QCOMPARE(hardlinks.value("copy.txt"), "original.txt");
+    QCOMPARE(hardlinks.value("device.txt"), "original.txt");
+
+    QCOMPARE(reader.fileData("copy.txt"), data);
+    QCOMPARE(reader.fileData("device.txt"), data);
+    QCOMPARE(reader.fileData("chain.txt"), data);
+
+    QHash<QString, QByteArray> linked = reader.filesData({"chain.txt", "other.txt"});
+    QCOMPARE(linked.size(), 2);
+    QCOMPARE(linked.value("chain.txt"), data);
+    QCOMPARE(linked.value("other.txt"), "other");
+
+    QVERIFY(reader.buildIndex());
+    QCOMPARE(reader.fileData("chain.txt"), data);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(reader.extractTo(dir.path()));
+
+    QFile copy{QDir{dir.path()}.filePath("copy.txt")};
+    QVERIFY(copy.open(QIODevice::ReadOnly));
+    QCOMPARE(copy.readAll(), data);
+}
+
+void BasicFileIoTest::testAddTreeDeduplication()
+{
+    QTemporaryDir source;
+    QVERIFY(source.isValid());
+
+    QDir root{source.path()};
+    QVERIFY(root.mkpath("sub"));
+
+    QByteArray data = QByteArray{"tree "}.repeated(1000);
+
+    for (const QString& path : {"a.txt", "b.txt", "sub/c.txt"}) {
+        QFile file{root.filePath(path)};
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(data), data.size());
+    }
+
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    {
+        QtLibArchive::WriterOptions options;
+        options.deduplicate = true;
+
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::None,
+            options};
+        QVERIFY(writer.addTree(source.path()));
+    }
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    auto it = reader.iterator();
+    QHash<QString, QString> hardlinks;
+    while (auto entry = it.next()) {
+        if (std::optional<QString> hardlink = entry->hardlink()) {
+            hardlinks.insert(*entry->pathName(), *hardlink);
+        }
+    }
+
+    QCOMPARE(hardlinks.size(), 2);
+    QCOMPARE(hardlinks.value("b.txt"), "a.txt");
+    QCOMPARE(hardlinks.value("sub/c.txt"), "a.txt");
+    QCOMPARE(reader.fileData("sub/c.txt"), data);
+
+void BasicFileIoTest::testWriteToMemoryAndDevice()
+{
+    QByteArray data = QByteArray{"streamed "}.repeated(100000);
+
+    QByteArray archiveData{"stale"};
+    {
+        QtLibArchive::Writer writer{
+            &archiveData, QtLibArchive::SupportedFormat::Tar, QtLibArchive::SupportedFilter::Gzip};
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+        QVERIFY(writer.addFile("memory.txt", data));
+    }
+
+    QVERIFY(!archiveData.isEmpty());
+    QVERIFY(archiveData.size() < data.size());
+
+    QtLibArchive::Reader memoryReader = QtLibArchive::Reader::fromData(archiveData);
+    QCOMPARE(memoryReader.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(memoryReader.fileData("memory.txt"), data);
+
+    QByteArray deviceData;
+    QBuffer buffer{&deviceData};
+    {
+        QtLibArchive::Writer writer{
+            &buffer, QtLibArchive::SupportedFormat::Zip, QtLibArchive::SupportedFilter::None};
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+        QVERIFY(writer.addFile("device.txt", data));
+        writer.close();
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+    }
+
+    // The writer opened the buffer and leaves it open.
+    QVERIFY(buffer.isOpen());
+    buffer.close();
+
+    QtLibArchive::Reader deviceReader = QtLibArchive::Reader::fromDevice(&buffer);
+    QCOMPARE(deviceReader.error(), QtLibArchive::ReaderError::None);
+    QCOMPARE(deviceReader.fileData("device.txt"), data);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Buffered files are flushed on close, while they stay open.
+    QFile file{QDir{dir.path()}.filePath("file.zip")};
+    {
+        QtLibArchive::Writer writer{
+            &file, QtLibArchive::SupportedFormat::Zip, QtLibArchive::SupportedFilter::None};
+        QVERIFY(writer.addFile("file.txt", data));
+        writer.close();
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+    }
+
+    QVERIFY(file.isOpen());
+    QCOMPARE(QtLibArchive::Reader{file.fileName()}.fileData("file.txt"), data);
+    file.close();
+
+    QSaveFile saveFile{QDir{dir.path()}.filePath("saved.zip")};
+    QVERIFY(saveFile.open(QIODevice::WriteOnly));
+    {
+        QtLibArchive::Writer writer{
+            &saveFile, QtLibArchive::SupportedFormat::Zip, QtLibArchive::SupportedFilter::None};
+        QVERIFY(writer.addFile("saved.txt", data));
+        writer.close();
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+    }
+
+    QVERIFY(saveFile.commit());
+    QCOMPARE(QtLibArchive::Reader{saveFile.fileName()}.fileData("saved.txt"), data);
+
+    QFile readOnly{QDir::temp().filePath("qtlibarchive-missing/archive.tar")};
+    QtLibArchive::Writer failing{
+        &readOnly, QtLibArchive::SupportedFormat::Tar, QtLibArchive::SupportedFilter::None};
+    QCOMPARE(failing.error(), QtLibArchive::WriterError::CannotOpenFile);
+}
+
+void BasicFileIoTest::testWriteToStalledDevice()
+{
+    StalledDevice device;
+    QVERIFY(device.open(QIODevice::WriteOnly));
+
+    QtLibArchive::WriterOptions options;
+    options.deviceWriteTimeout = 50;
+
+    QtLibArchive::Writer writer{
+        &device,
+        QtLibArchive::SupportedFormat::TarPaxRestricted,
+        QtLibArchive::SupportedFilter::None,
+        options};
+    QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+    QVERIFY(writer.addFile("a.txt", QByteArray{"data"}));
+
+    // The data never leaves the device, so waiting for it gives up after the timeout.
+    writer.close();
+    QCOMPARE(writer.error(), QtLibArchive::WriterError::CannotWriteData);
+    QCOMPARE(device.lastTimeout(), 50);
+
+void BasicFileIoTest::testFilterChainAndFormatOptions()
+{
+    QByteArray data = QByteArray{"compressible "}.repeated(10000);
+
+    QByteArray chained;
+    {
+        QtLibArchive::Writer writer{
+            &chained,
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            {QtLibArchive::SupportedFilter::Gzip, QtLibArchive::SupportedFilter::Uu}};
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+        QVERIFY(writer.addFile("chained.txt", data));
+    }
+
+    QVERIFY(chained.startsWith("begin "));
+    QCOMPARE(QtLibArchive::Reader::fromData(chained).fileData("chained.txt"), data);
+
+    auto writeZip = [&data](QtLibArchive::CompressionMethod method) {
+        QtLibArchive::WriterOptions options;
+        options.compressionMethod = method;
+        options.compressionMethodLevel = 9;
+
+        QByteArray archiveData;
+        QtLibArchive::Writer writer{
+            &archiveData,
+            QtLibArchive::SupportedFormat::Zip,
+            QtLibArchive::SupportedFilter::None,
+            options};
+        writer.addFile("zipped.txt", data);
+        writer.close();
+
+        return writer.error() == QtLibArchive::WriterError::None ? archiveData : QByteArray{};
+    };
+
+    QByteArray stored = writeZip(QtLibArchive::CompressionMethod::Store);
+    QByteArray deflated = writeZip(QtLibArchive::CompressionMethod::Deflate);
+
+    QVERIFY(stored.size() > data.size());
+    QVERIFY(deflated.size() < data.size() / 10);
+    QCOMPARE(QtLibArchive::Reader::fromData(stored).fileData("zipped.txt"), data);
+    QCOMPARE(QtLibArchive::Reader::fromData(deflated).fileData("zipped.txt"), data);
+
+    QtLibArchive::WriterOptions invalid;
+    invalid.formatOptions = {{"zip", "no-such-option", "1"}};
+
+    QByteArray unused;
+    QtLibArchive::Writer writer{
+        &unused, QtLibArchive::SupportedFormat::Zip, QtLibArchive::SupportedFilter::None, invalid};
+    QCOMPARE(writer.error(), QtLibArchive::WriterError::CannotSetFormatOption);
+}
+
+void BasicFileIoTest::testCompressionPolicy()
+{
+    QByteArray text = QByteArray{"compressible "}.repeated(10000);
+
+    QByteArray random(100000, Qt::Uninitialized);
+    std::generate(random.begin(), random.end(), []() -> char {
+        return static_cast<char>(QRandomGenerator::global()->bounded(256));
+    });
+
+    QVERIFY(!QtLibArchive::Writer::looksCompressed(text));
+    QVERIFY(QtLibArchive::Writer::looksCompressed(random));
+    QVERIFY(QtLibArchive::Writer::looksCompressed(QByteArray{"\x89PNG\r\n\x1A\n"}));
+
+    QStringList policyPaths;
+
+    QtLibArchive::WriterOptions options;
+    options.storeIncompressible = true;
+    options.compressionPolicy = [&policyPaths](const QString& path, const QByteArray&)
+        -> std::optional<QtLibArchive::CompressionMethod> {
+        policyPaths.push_back(path);
+        if (path.endsWith(".raw")) {
+            return QtLibArchive::CompressionMethod::Store;
+        }
+
+        return std::nullopt;
+    };
+
+    QByteArray archiveData;
+    {
+        QtLibArchive::Writer writer{
+            &archiveData,
+            QtLibArchive::SupportedFormat::Zip,
+            QtLibArchive::SupportedFilter::None,
+            options};
+        QVERIFY(writer.addFile("random.bin", random));
+        QVERIFY(writer.addFile("text.txt", text));
+        writer.close();
+        QCOMPARE(writer.error(), QtLibArchive::WriterError::None);
+    }
+
+    QCOMPARE(policyPaths, (QStringList{"random.bin", "text.txt"}));
+
+    // The random data is stored, the text deflated.
+    QVERIFY(archiveData.size() < random.size() + text.size() / 10);
+
+    QByteArray storedText;
+    {
+        QtLibArchive::Writer writer{
+            &storedText,
+            QtLibArchive::SupportedFormat::Zip,
+            QtLibArchive::SupportedFilter::None,
+            options};
+        QVERIFY(writer.addFile("text.raw", text));
+        QVERIFY(writer.addFile("text.txt", text));
+    }
+
+    QVERIFY(storedText.size() > text.size());
+    QVERIFY(storedText.size() < text.size() + text.size() / 10);
+
+    QtLibArchive::Reader reader = QtLibArchive::Reader::fromData(storedText);
+    QCOMPARE(reader.fileData("text.raw"), text);
+    QCOMPARE(reader.fileData("text.txt"), text);
+
+    // libarchive cannot switch to other methods once the archive is open.
+    QtLibArchive::WriterOptions bzip2Options;
+    bzip2Options.compressionPolicy =
+        [](const QString&, const QByteArray&) -> std::optional<QtLibArchive::CompressionMethod> {
+        return QtLibArchive::CompressionMethod::Bzip2;
+    };
+
+    QByteArray rejected;
+    QtLibArchive::Writer bzip2Writer{
+        &rejected,
+        QtLibArchive::SupportedFormat::Zip,
+        QtLibArchive::SupportedFilter::None,
+        bzip2Options};
+    QVERIFY(!bzip2Writer.addFile("text.txt", text));
+    QCOMPARE(bzip2Writer.error(), QtLibArchive::WriterError::CannotSetFormatOption);
+}
+
+void BasicFileIoTest::testStatistics()
+{
+    QTemporaryFile archive;
+    QVERIFY(archive.open());
+
+    QByteArray data = QByteArray{"statistics "}.repeated(10000);
+    QList<QtLibArchive::Statistics> writerReports;
+
+    {
+        QtLibArchive::WriterOptions options;
+        options.statisticsCallback = [&writerReports](const QtLibArchive::Statistics& statistics) {
+            writerReports.push_back(statistics);
+        };
+
+        QtLibArchive::Writer writer{
+            archive.fileName(),
+            QtLibArchive::SupportedFormat::TarPaxRestricted,
+            QtLibArchive::SupportedFilter::Gzip,
+            options};
+        QVERIFY(writer.addDirectory("dir"));
+        QVERIFY(writer.addFile("dir/first.txt", data));
+        QVERIFY(writer.addFile("dir/second.txt", data));
+        QCOMPARE(writer.statistics().headers, 3);
+    }
+
+    QCOMPARE(writerReports.size(), 1);
+    const QtLibArchive::Statistics& written = writerReports.first();
+    QCOMPARE(written.headers, 3);
+    QVERIFY(written.filters.size() >= 2);
+    QCOMPARE(written.filters.first().name, "gzip");
+    QVERIFY(written.filters.first().bytes > 2 * data.size());
+    QCOMPARE(written.filters.last().bytes, QFileInfo{archive.fileName()}.size());
+    QVERIFY(written.ioNanoseconds > 0);
+    QVERIFY(written.codecNanoseconds > 0);
+    QVERIFY(written.elapsedNanoseconds >= written.ioNanoseconds + written.codecNanoseconds);
+
+    QtLibArchive::Reader reader{archive.fileName()};
+    QVERIFY(!reader.isStatisticsEnabled());
+    QCOMPARE(reader.statistics().headers, 0);
+
+    int reports = 0;
+    reader.setStatisticsCallback([&reports](const QtLibArchive::Statistics&) { reports++; });
+    reader.setStatisticsEnabled(true);
+
+    {
+        QtLibArchive::ReaderIterator it = reader.iterator();
+        while (it.next()) {
+        }
+
+        QtLibArchive::Statistics iterated = it.statistics();
+        QCOMPARE(iterated.headers, 3);
+        QCOMPARE(iterated.entriesSkipped, 2);
+        QVERIFY(iterated.peakBufferBytes > 0);
+        QVERIFY(iterated.filters.size() >= 2);
+        QCOMPARE(iterated.filters.last().bytes, QFileInfo{archive.fileName()}.size());
+    }
+
+    QCOMPARE(reports, 1);
+    QCOMPARE(reader.fileData("dir/second.txt"), data);
+    QCOMPARE(reports, 2);
+
+    QtLibArchive::Statistics total = reader.statistics();
+    QCOMPARE(total.headers, 6);
+    QCOMPARE(total.entriesSkipped, 3);
+    QVERIFY(total.filters.first().bytes >= 2 * data.size());
+}
+
+void BasicFileIoTest::testSequentialDeviceStatistics()
+{
+    QByteArray data = QByteArray{"sequential "}.repeated(1000);
+
+    QByteArray archiveData;
+    {
+        QtLibArchive::Writer writer{
+            &archiveData, QtLibArchive::SupportedFormat::Tar, QtLibArchive::SupportedFilter::Gzip};
+        QVERIFY(writer.addFile("a.txt", data));
+        QVERIFY(writer.addFile("b.txt", data));
+    }
+
+    // The device was already probed, so enabling statistics must keep the opened handle.
+    SequentialDevice sequential{archiveData};
+    QtLibArchive::Reader reader = QtLibArchive::Reader::fromDevice(&sequential);
+    QCOMPARE(reader.error(), QtLibArchive::ReaderError::None);
+
+    int reports = 0;
+    reader.setStatisticsEnabled(true);
+    reader.setStatisticsCallback([&reports](const QtLibArchive::Statistics&) { reports++; });
+
+    {
+        QtLibArchive::ReaderIterator it = reader.iterator();
+        QCOMPARE(it.error(), QtLibArchive::ReaderError::None);
+        QVERIFY(it.next());
+        QCOMPARE(it.readData(), data);
+        QVERIFY(it.next());
+        QCOMPARE(it.readData(), data);
+        QVERIFY(!it.next());
+        QCOMPARE(it.error(), QtLibArchive::ReaderError::None);
+        QCOMPARE(it.statistics().headers, 2);
+    }
+
+    QCOMPARE(reports, 1);
+    QCOMPARE(reader.statistics().headers, 2);
+}
+
 QTEST_APPLESS_MAIN(BasicFileIoTest)
 
 #include "BasicFileIoTest.moc"